@@ -0,0 +1,86 @@
+/**
+ @file CancelToken.h
+ @brief A cooperative cancellation token with an optional time budget
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#ifndef  CancelToken_INC
+#define  CancelToken_INC
+
+#include <atomic>
+#include <chrono>
+
+#include "namespace.h"
+
+BIO_NAMESPACE_BEGIN
+
+/**
+ * @brief A flag that long running computations check to stop early.
+ *
+ * A token is stopped when cancel() has been called on it or on its parent, or
+ * when its time budget has run out. Nothing is interrupted: the computation
+ * polls the token (e.g. from an ODE right hand side callback) and gives up
+ * when getStatus() is not SATOOLS_SUCCESS.
+ *
+ * cancel() and the getters may be called from any thread; setBudget() and
+ * setParent() must be called by the thread owning the computation.
+ * */
+class CancelToken
+{
+  public:
+    /**
+     * @brief Constructor
+     *
+     * @param parent a token whose cancellation also cancels this one
+     * */
+    CancelToken(const CancelToken* parent = nullptr);
+
+    void setParent(const CancelToken* parent);
+
+    /**
+     * @brief Requests cancellation
+     * */
+    void cancel();
+
+    /**
+     * @brief Clears a cancellation request and the time budget
+     * */
+    void reset();
+
+    /**
+     * @brief Starts a time budget counted from now
+     *
+     * @param seconds wall-clock time budget, a non-positive value means
+     * unlimited
+     * */
+    void setBudget(const double seconds);
+
+    /**
+     * @brief Returns true if the computation should stop
+     * */
+    bool isStopped() const;
+
+    /**
+     * @brief Returns why the computation should stop
+     *
+     * @retval SATOOLS_SUCCESS the computation may go on
+     * @retval ERROR_SIMULATION_CANCELLED cancel() has been called on the
+     * token or one of its parents
+     * @retval ERROR_TIME_BUDGET_EXCEEDED the time budget has run out
+     * */
+    int getStatus() const;
+  private:
+    bool isCancelled() const;
+
+    std::atomic<bool> m_Cancelled;
+    const CancelToken* m_Parent;
+    bool m_HasDeadline;
+    std::chrono::steady_clock::time_point m_Deadline;
+
+    CancelToken(const CancelToken& other) = delete;
+    CancelToken& operator=(const CancelToken& other) = delete;
+};
+
+BIO_NAMESPACE_END
+
+#endif   /* ----- #ifndef CancelToken_INC  ----- */
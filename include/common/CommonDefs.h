@@ -28,3 +28,5 @@
 #define ERROR_AST_EVALUATION 2002
 #define FATAL_AST_EVALUATION 2003
 #define ERROR_CVODE_ERROR 2004
+#define ERROR_TIME_BUDGET_EXCEEDED 2005 //the simulation ran past its wall-clock budget
+#define ERROR_SIMULATION_CANCELLED 2006 //the simulation was cancelled
@@ -0,0 +1,103 @@
+/**
+ @file BoundedQueue.h
+ @brief A blocking FIFO queue with a fixed capacity
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#ifndef  BoundedQueue_INC
+#define  BoundedQueue_INC
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#include "common/namespace.h"
+
+BIO_NAMESPACE_BEGIN
+
+/**
+ * @brief A thread-safe FIFO queue holding at most a fixed number of items.
+ *
+ * push() blocks while the queue is full, pop() blocks while it is empty.
+ * Once the queue is closed, push() fails and pop() fails as soon as the
+ * remaining items have been taken.
+ * */
+template <typename T> class BoundedQueue
+{
+  public:
+    /**
+     * @brief Constructor
+     *
+     * @param capacity maximum number of items in the queue
+     * */
+    BoundedQueue(const int capacity)
+      : m_Capacity(capacity > 0 ? capacity : 1)
+      , m_Closed(false)
+    {
+    }
+
+    /**
+     * @brief Appends an item, waits if the queue is full
+     *
+     * @return false if the queue has been closed
+     * */
+    bool push(const T& value)
+    {
+      std::unique_lock<std::mutex> lock(m_Lock);
+      m_NotFull.wait(lock, [this]
+          {
+            return m_Closed || (int) m_Items.size() < m_Capacity;
+          });
+      if (m_Closed)
+        return false;
+      m_Items.push_back(value);
+      m_NotEmpty.notify_one();
+      return true;
+    }
+
+    /**
+     * @brief Takes the first item, waits if the queue is empty
+     *
+     * @return false if the queue is closed and empty
+     * */
+    bool pop(T& value)
+    {
+      std::unique_lock<std::mutex> lock(m_Lock);
+      m_NotEmpty.wait(lock, [this]
+          {
+            return m_Closed || !m_Items.empty();
+          });
+      if (m_Items.empty())
+        return false;
+      value = m_Items.front();
+      m_Items.pop_front();
+      m_NotFull.notify_one();
+      return true;
+    }
+
+    /**
+     * @brief Closes the queue and wakes up all waiting threads
+     * */
+    void close()
+    {
+      std::lock_guard<std::mutex> lock(m_Lock);
+      m_Closed = true;
+      m_NotEmpty.notify_all();
+      m_NotFull.notify_all();
+    }
+
+  private:
+    int m_Capacity;
+    bool m_Closed;
+    std::deque<T> m_Items;
+    std::mutex m_Lock;
+    std::condition_variable m_NotEmpty;
+    std::condition_variable m_NotFull;
+
+    BoundedQueue(const BoundedQueue& other) = delete;
+    BoundedQueue& operator=(const BoundedQueue& other) = delete;
+};
+
+BIO_NAMESPACE_END
+
+#endif   /* ----- #ifndef BoundedQueue_INC  ----- */
@@ -0,0 +1,106 @@
+/**
+ @file Checkpoint.h
+ @brief An append-only log of the simulations of an analysis
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#ifndef  Checkpoint_INC
+#define  Checkpoint_INC
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/namespace.h"
+#include "DesignRows.h"
+#include "ResultMatrix.h"
+
+BIO_NAMESPACE_BEGIN
+
+/**
+ * @brief Records the progress of SABase::analyze() in a memory-mapped file.
+ *
+ * The file holds, in order of writing, the state of the random generators
+ * when the analysis started, the design of every call to SABase::simulate()
+ * (a wave) and the outputs and labels of the rows completed so far. Records
+ * are only appended and a record only counts once the length in the file
+ * header covers it, thus a killed process leaves a valid log behind. Writes
+ * are plain copies into the mapping, flushing is left to the kernel.
+ *
+ * When resuming, the analysis restarts from the saved generator state so it
+ * produces the same waves again. Each wave is compared with its recorded
+ * design and the completed rows are restored instead of being simulated.
+ * */
+class Checkpoint
+{
+  public:
+    /**
+     * @brief Constructor
+     *
+     * @param path the checkpoint file
+     * @param nInputs number of model inputs
+     * @param nOutputs number of model outputs
+     * @param method the SAMethod_t of the analysis
+     * @param resume true to continue from an existing file, false to start a
+     * new log
+     * */
+    Checkpoint(const std::string& path, const int nInputs, const int nOutputs,
+        const int method, const bool resume);
+    ~Checkpoint();
+
+    /**
+     * @brief Returns the saved generator state, empty if none
+     * */
+    const std::string& getState() const;
+    void saveState(const std::string& state);
+
+    /**
+     * @brief Starts a wave
+     *
+     * A new wave has its design recorded. A recorded wave must have the same
+     * design, its completed rows are copied into outputs.
+     *
+     * @param wave index of the wave in the analysis
+     * @param inputs the design
+     * @param outputs the outputs of the wave
+     * @param done set to 1 for every restored row
+     * */
+    void beginWave(const int wave, const DesignRows& inputs, ResultMatrix& outputs,
+        std::vector<char>& done);
+
+    /**
+     * @brief Records completed rows of a wave
+     *
+     * Rows labeled SIM_TIMEOUT or SIM_CANCELLED are skipped so that they are
+     * simulated again on resume. Thread-safe.
+     * */
+    void saveRows(const int wave, const int begin, const int count,
+        const double* const* outputs, const int* labels);
+  private:
+    char* append(const int type, const int wave, const int begin,
+        const int count, const size_t bytes);
+    void commit();
+    void reserve(const size_t size);
+    void load();
+    void close();
+
+    int m_NumInputs;
+    int m_NumOutputs;
+    std::string m_State;
+    std::map<int, size_t> m_Waves;              /* offsets of wave records */
+    std::map<int, std::vector<size_t> > m_Rows; /* offsets of row records per wave */
+
+    int m_File;
+    char* m_Map;
+    size_t m_MapSize;
+    size_t m_Length;                            /* bytes written */
+    std::mutex m_Lock;
+
+    Checkpoint(const Checkpoint& other) = delete;
+    Checkpoint& operator=(const Checkpoint& other) = delete;
+};
+
+BIO_NAMESPACE_END
+
+#endif   /* ----- #ifndef Checkpoint_INC  ----- */
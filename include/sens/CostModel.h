@@ -0,0 +1,65 @@
+/**
+ @file CostModel.h
+ @brief Predicts the cost of simulating a sample from measured costs
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#ifndef  CostModel_INC
+#define  CostModel_INC
+
+#include <vector>
+
+#include "common/namespace.h"
+
+BIO_NAMESPACE_BEGIN
+
+/**
+ * @brief A nearest-neighbour regression of simulation costs.
+ *
+ * Keeps the inputs and measured costs of recent samples and predicts the
+ * cost of a new sample as the mean cost of its nearest kept samples. The
+ * inputs are scaled by the observed range of each column so that factors
+ * with large values do not dominate the distances.
+ * */
+class CostModel
+{
+  public:
+    /**
+     * @brief Constructor
+     *
+     * @param capacity maximum number of kept samples, the oldest ones are
+     * replaced first
+     * @param neighbours number of nearest samples averaged by predict()
+     * */
+    CostModel(const int capacity = 512, const int neighbours = 3);
+
+    void clear();
+    bool empty() const;
+
+    /**
+     * @brief Records the measured cost of a sample
+     *
+     * @param inputs the sample
+     * @param nInputs number of inputs, the same for every sample
+     * @param cost the cost
+     * */
+    void add(const double* inputs, const int nInputs, const double cost);
+
+    /**
+     * @brief Predicts the cost of a sample, 0 if nothing has been recorded
+     * */
+    double predict(const double* inputs) const;
+  private:
+    int m_Capacity;
+    int m_Neighbours;
+    int m_NumInputs;
+    long m_NumAdded;                            /* samples recorded so far */
+    std::vector<double> m_Inputs;               /* kept samples, row by row */
+    std::vector<double> m_Costs;
+    std::vector<double> m_Min;                  /* range of each input */
+    std::vector<double> m_Max;
+};
+
+BIO_NAMESPACE_END
+
+#endif   /* ----- #ifndef CostModel_INC  ----- */
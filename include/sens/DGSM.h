@@ -7,6 +7,8 @@
 #ifndef  DGSM_INC
 #define  DGSM_INC
 
+#include <vector>
+
 #include "SALessSimple.h"
 
 BIO_NAMESPACE_BEGIN
@@ -29,9 +31,39 @@ class DGSM : public SALessSimple
     int getNumSens() const;
     
     void doSA();
+    /**
+     * @brief Fills xdiff with the samples x shifted by delta on one column,
+     * then converts it to target distributions
+     *
+     * @param x samples on the unit hypercube, or consecutive rows of them
+     * @param xdiff matrix (same size as x) to hold the shifted samples
+     * @param col the column to be shifted
+     * */
+    void perturb(DMatrix& x, DMatrix& xdiff, const int col);
+    /**
+     * @brief Estimates the sensitivity measures of a factor for all outputs
+     *
+     * @param iK index of the factor
+     * @param X the first N samples and y their outputs
+     * @param xdiff column iK of the shifted samples and ydiff their outputs
+     * */
+    void estimate(const int iK, DMatrix& X, ResultMatrix& y, const double* xdiff, ResultMatrix& ydiff);
+    /**
+     * @brief Computes the measures of a factor from resampled derivatives
+     *
+     * @param derivs derivatives of the outputs, one vector of N per output
+     * @param valid flags of the samples with successful simulations
+     * @param units indexes of the N resampled samples
+     * @param sens row of the factor in the matrix of measures
+     * @param check throws if too many simulations have failed
+     * */
+    void measure(const double* derivs, const char* valid,
+        const int* units, double* sens, const bool check);
 
     int N_;
     double delta_;
+    std::vector<double> derivs_;                /* derivatives kept for bootstrapping */
+    std::vector<char> valid_;                   /* their validity flags */
 };
 
 BIO_NAMESPACE_END
@@ -0,0 +1,82 @@
+/**
+ @file DesignRows.h
+ @brief Read access to the rows of a design
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#ifndef  DesignRows_INC
+#define  DesignRows_INC
+
+#include <vector>
+
+#include "common/namespace.h"
+#include "Matrix.h"
+
+BIO_NAMESPACE_BEGIN
+
+/**
+ * @brief The rows of a design, as read by SABase::simulate()
+ *
+ * A design is either held in a matrix or composed from other matrices when
+ * its rows are read, in which case it takes no memory of its own.
+ * */
+class DesignRows
+{
+  public:
+    virtual ~DesignRows();
+
+    virtual int getNumRows() const = 0;
+    virtual int getNumCols() const = 0;
+    /**
+     * @brief Returns row @param iRow
+     *
+     * @param buf room for getNumCols() values, where a composed row is
+     * written
+     * @return the row, valid until buf is reused
+     * */
+    virtual const double* getRow(const int iRow, double* buf) const = 0;
+};
+
+/**
+ * @brief The rows of a matrix
+ * */
+class MatrixRows : public DesignRows
+{
+  public:
+    MatrixRows(const DMatrix& mat);
+
+    int getNumRows() const override;
+    int getNumCols() const override;
+    const double* getRow(const int iRow, double* buf) const override;
+  private:
+    const DMatrix& m_Matrix;
+};
+
+/**
+ * @brief The rows of a matrix with some columns taken from another matrix,
+ * as the radial designs C_i of the Sobol indices
+ * */
+class RadialRows : public DesignRows
+{
+  public:
+    /**
+     * @brief Constructor
+     *
+     * @param base the matrix giving the rows
+     * @param source the matrix giving the columns @param cols, of the same
+     * size
+     * */
+    RadialRows(const DMatrix& base, const DMatrix& source, const std::vector<int>& cols);
+
+    int getNumRows() const override;
+    int getNumCols() const override;
+    const double* getRow(const int iRow, double* buf) const override;
+  private:
+    const DMatrix& m_Base;
+    const DMatrix& m_Source;
+    std::vector<int> m_Cols;
+};
+
+BIO_NAMESPACE_END
+
+#endif   /* ----- #ifndef DesignRows_INC  ----- */
@@ -25,6 +25,29 @@ class EFAST : public FASTBase
     void doSA() override;
     int getNumSens() const override;
     void initOmegas(int* omegas, const int N) const;
+    /**
+     * @brief Samples a search curve for a factor with random phase shifts
+     *
+     * @param x matrix to hold the curve, one row per point
+     * @param omegas frequencies, omegas[0] is assigned to the factor
+     * @param s values of the curve parameter
+     * @param phis vector (allocated by callers) to hold the phase shifts
+     * @param iFactor index of the factor of interest
+     * @param rng stream of the random phase shifts
+     * */
+    void sampleCurve(DMatrix& x, const int* omegas, const double* s, double* phis, const int iFactor,
+        RNGStream& rng);
+    /**
+     * @brief Draws the random phase shifts of a search curve
+     * */
+    void drawPhases(double* phis, RNGStream& rng);
+    /**
+     * @brief Fills consecutive points of a search curve, see sampleCurve()
+     *
+     * @param s values of the curve parameter of the points, one per row of x
+     * */
+    void fillCurve(DMatrix& x, const int* omegas, const double* s, const double* phis,
+        const int iFactor);
     void directVariances(const double* y, const double* s, const int N, const int omega, double* v);
     void fftVariances(double* y, const int N, const int omega, double* v);
     int Nr_;                                    /* number of search curves */
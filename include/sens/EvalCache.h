@@ -0,0 +1,112 @@
+/**
+ @file EvalCache.h
+ @brief A content-addressed cache of model evaluations
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#ifndef  EvalCache_INC
+#define  EvalCache_INC
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/namespace.h"
+
+BIO_NAMESPACE_BEGIN
+
+class ModelEvaluator;
+
+/**
+ * @brief Remembers the outputs and label of every evaluated input row.
+ *
+ * A row is addressed by a hash of its values and of a fingerprint describing
+ * the model and its solver settings, so a cache can be shared by several
+ * analyses of the same model, e.g. SobolSaltelli followed by Morris, and
+ * results computed under other settings are never returned. Rows are
+ * compared bitwise on lookup, a hash collision is thus a plain miss.
+ *
+ * The records live in memory or, if a file is given, in a memory-mapped file
+ * which later processes reopen to reuse the results. Only one process may
+ * use a file at a time. Samples labeled SIM_TIMEOUT or SIM_CANCELLED are
+ * not cached since they may succeed on the next run.
+ *
+ * All methods are thread-safe.
+ * */
+class EvalCache
+{
+  public:
+    /**
+     * @brief Constructor
+     *
+     * @param nInputs number of model inputs
+     * @param nOutputs number of model outputs
+     * @param fingerprint any text identifying the model and its settings
+     * @param path the backing file, created if missing; an empty path keeps
+     * the records in memory
+     * */
+    EvalCache(const int nInputs, const int nOutputs,
+        const std::string& fingerprint, const std::string& path = "");
+    ~EvalCache();
+
+    /**
+     * @brief Looks up an input row
+     *
+     * @return true and fills outputs and label if the row has been cached
+     * */
+    bool lookup(const double* inputs, double* outputs, int* label) const;
+
+    /**
+     * @brief Stores the evaluation of an input row
+     * */
+    void store(const double* inputs, const double* outputs, const int label);
+
+    /**
+     * @brief Evaluates a block of samples, solving only the uncached ones
+     *
+     * The arguments follow ModelEvaluator::solveBatch(), the new results
+     * are stored.
+     * */
+    void solveBatch(const ModelEvaluator& eval, const double* const* inputs,
+        double* const* outputs, int* labels, const int num);
+
+    int getNumInputs() const;
+    int getNumOutputs() const;
+    int size() const;
+    long getNumHits() const;
+    long getNumMisses() const;
+  private:
+    uint64_t hash(const double* inputs) const;
+    int find(const uint64_t key, const double* inputs) const;
+    char* getRecord(const int index) const;
+    void openFile(const std::string& path);
+    void reserve(const int capacity);
+
+    int m_NumInputs;
+    int m_NumOutputs;
+    uint64_t m_Fingerprint;                     /* hash of the fingerprint text */
+    size_t m_RecordSize;                        /* bytes per record */
+    int m_Size;                                 /* number of records */
+    int m_Capacity;                             /* number of allocated records */
+    char* m_Records;                            /* first record */
+
+    std::vector<char> m_Buffer;                 /* records without backing file */
+    int m_File;                                 /* backing file descriptor, -1 if none */
+    char* m_Map;                                /* mapped file */
+    size_t m_MapSize;
+
+    std::unordered_multimap<uint64_t, int> m_Index;
+    mutable std::mutex m_Lock;
+    mutable std::atomic<long> m_Hits;
+    mutable std::atomic<long> m_Misses;
+
+    EvalCache(const EvalCache& other) = delete;
+    EvalCache& operator=(const EvalCache& other) = delete;
+};
+
+BIO_NAMESPACE_END
+
+#endif   /* ----- #ifndef EvalCache_INC  ----- */
@@ -0,0 +1,89 @@
+/**
+ @file GivenData.h
+ @brief First order indices from a given sample
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#ifndef  GivenData_INC
+#define  GivenData_INC
+
+#include <vector>
+
+#include "SABase.h"
+
+BIO_NAMESPACE_BEGIN
+
+/**
+ * @brief First order Sobol indices estimated from any sample of the inputs
+ * and its simulation results, without a structured design, see \cite
+ * Plischke2010.
+ *
+ * The samples are sorted along each factor and cut into M bins of equal
+ * size. The variance of the bin means of the output estimates the variance
+ * of its conditional expectation, corrected for the variance of the means
+ * within the bins:
+ *
+ *   S_i = (SSB - (M-1)*SSW/(N-M)) / SST
+ *
+ * where SSB, SSW and SST are the between-bin, within-bin and total sums of
+ * squares. A factor costs one sort of the sample, in O(N*log(N)), and the
+ * factors are processed in parallel. Bootstrap resamples reuse the sorted
+ * samples, weighted by their number of draws, and the correction then
+ * accounts for the repeated samples.
+ *
+ * The sample is given by setData(), for example the inputs and outputs of
+ * an earlier analysis of the same model. Without data, N samples are drawn
+ * following the sampling method and simulated. The samples must be
+ * independent and distributed as the inputs, as those of MC_SAMPLING and
+ * LHS_SAMPLING.
+ * */
+class GivenData : public SABase
+{
+  public:
+    GivenData();
+    /**
+     * @brief Sets the number of samples simulated when no data are given
+     *
+     * @param N number of samples, at least 2
+     * */
+    void setN(const int N);
+    /**
+     * @brief Sets the number of bins per factor
+     *
+     * @param num number of bins, 0 means the square root of the number of
+     * samples
+     * */
+    void setNumBins(const int num);
+    /**
+     * @brief Sets the sample to be analyzed instead of simulating one
+     *
+     * The data are copied. Failed simulations are ignored.
+     *
+     * @param inputs one row per sample, one column per model input
+     * @param outputs the simulation results of the rows of @param inputs
+     * */
+    void setData(const DMatrix& inputs, const ResultMatrix& outputs);
+  private:
+    int getNumSens() const override;
+    void doSA() override;
+    void sample();
+    void estimate();
+    /**
+     * @brief Estimates the indices of the factors [begin, end) from a
+     * weighted sample, in one pass over each sorted factor
+     *
+     * @param weights number of times each sample is taken
+     * @param sens matrix to hold the indices
+     * */
+    void estimate(const std::vector<int>& weights, const int begin, const int end,
+        DMatrix& sens) const;
+
+    int N_;                                     /* number of simulated samples */
+    int numBins_;                               /* 0 for the square root of the sample size */
+    bool given_;                                /* data set by setData()? */
+    std::vector<std::vector<int> > order_;      /* valid samples sorted along each factor */
+};
+
+BIO_NAMESPACE_END
+
+#endif   /* ----- #ifndef GivenData_INC  ----- */
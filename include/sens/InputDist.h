@@ -7,6 +7,8 @@
 #ifndef  InputDist_INC
 #define  InputDist_INC
 
+#include <vector>
+
 #include "common/namespace.h"
 
 BIO_NAMESPACE_BEGIN
@@ -16,13 +18,20 @@ typedef enum
   DIST_UNKNOWN = 0,
   DIST_UNIFORM,
   DIST_NORMAL,
+  DIST_LOGNORMAL,                               /* the types from here on are InputTabulated */
+  DIST_TRIANGULAR,
+  DIST_BETA,
+  DIST_PIECEWISE_LINEAR,
+  DIST_EMPIRICAL
 } InputDistType_t;
 
 class InputDist
 {
   public:
     InputDist(const InputDistType_t& type = DIST_UNKNOWN);
+    virtual ~InputDist() {}
     int getType() const { return m_Type; }
+    bool isTabulated() const { return m_Type >= DIST_LOGNORMAL; }
   protected:
     int m_Type;
 
@@ -63,6 +72,136 @@ class InputNormal : public InputDist
     double std_;
 };
 
+/**
+ * @brief A distribution sampled through a table of its quantile function.
+ *
+ * The table holds the quantiles of equally spaced probabilities from 0 to
+ * 1, so a uniform sample maps to a value by a linear interpolation between
+ * two entries, in O(1) whatever the distribution. Every interval between
+ * two entries gets exactly its probability, so the sampled distribution is
+ * within 1/(size-1) of the target in Kolmogorov distance. Distributions
+ * with unbounded support are truncated, as InputNormal is.
+ * */
+class InputTabulated : public InputDist
+{
+  public:
+    /* entries of the tables computed from a quantile function */
+    static const int TABLE_SIZE = 8193;
+
+    /**
+     * @brief Returns the quantiles of the probabilities j/(size-1)
+     * */
+    const std::vector<double>& getTable() const;
+
+    /**
+     * @brief Returns the interpolated quantile of @param p in [0,1]
+     * */
+    double quantile(const double p) const;
+
+  protected:
+    InputTabulated(const InputDistType_t& type);
+
+    /**
+     * @brief Fills the table with TABLE_SIZE quantiles of @param q and
+     * checks that it is non decreasing
+     * */
+    template<typename Quantile_t>
+    void tabulate(Quantile_t q)
+    {
+      m_Table.resize(TABLE_SIZE);
+      for (int j=0; j<TABLE_SIZE; ++j)
+        m_Table[j] = q((double) j/(TABLE_SIZE-1));
+      checkTable();
+    }
+    void checkTable() const;
+
+    std::vector<double> m_Table;
+};
+
+/**
+ * @brief exp(N(mu, sigma)) truncated to exp(mu +/- 3 sigma)
+ * */
+class InputLogNormal : public InputTabulated
+{
+  public:
+    /**
+     * @param mu mean of the logarithm
+     * @param sigma standard deviation of the logarithm
+     * */
+    InputLogNormal(const double mu, const double sigma);
+
+    double getMu() const;
+    double getSigma() const;
+
+  private:
+    double mu_;
+    double sigma_;
+};
+
+class InputTriangular : public InputTabulated
+{
+  public:
+    InputTriangular(const double lower, const double mode, const double upper);
+
+    double getLower() const;
+    double getMode() const;
+    double getUpper() const;
+
+  private:
+    double lower_;
+    double mode_;
+    double upper_;
+};
+
+/**
+ * @brief Beta(alpha, beta) scaled to [lower, upper]
+ * */
+class InputBeta : public InputTabulated
+{
+  public:
+    InputBeta(const double alpha, const double beta, const double lower = 0,
+        const double upper = 1);
+
+    double getAlpha() const;
+    double getBeta() const;
+
+  private:
+    double alpha_;
+    double beta_;
+};
+
+/**
+ * @brief A density linear between given points, as
+ * std::piecewise_linear_distribution
+ * */
+class InputPiecewiseLinear : public InputTabulated
+{
+  public:
+    /**
+     * @param xs increasing boundaries, at least 2
+     * @param densities non negative densities at the boundaries, not
+     * normalized
+     * */
+    InputPiecewiseLinear(const std::vector<double>& xs,
+        const std::vector<double>& densities);
+};
+
+/**
+ * @brief The distribution of a set of samples, e.g. from a posterior
+ *
+ * The sorted samples are the quantiles of the probabilities i/(n-1), so the
+ * table is the samples themselves and the quantile function interpolates
+ * between order statistics.
+ * */
+class InputEmpirical : public InputTabulated
+{
+  public:
+    /**
+     * @param samples at least 2 samples
+     * */
+    InputEmpirical(const std::vector<double>& samples);
+};
+
 BIO_NAMESPACE_END
 
 #endif   /* ----- #ifndef InputDist_INC  ----- */
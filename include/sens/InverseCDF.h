@@ -0,0 +1,67 @@
+/**
+ @file InverseCDF.h
+ @brief Batch inverse-CDF transforms of uniform samples
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#ifndef  InverseCDF_INC
+#define  InverseCDF_INC
+
+#include "common/namespace.h"
+
+BIO_NAMESPACE_BEGIN
+
+/**
+ * @brief Kernels mapping a contiguous block of [0,1] samples in place to a
+ * target distribution.
+ *
+ * The parameters of a distribution are folded once per block and the inner
+ * loops carry no branch nor call, so that the compiler can vectorize them.
+ * The results are bit for bit those of the scalar functions of normal.h.
+ * */
+namespace InverseCDF
+{
+  /**
+   * @brief Maps to U(lower, upper)
+   * */
+  void uniform(double* values, const int n, const double lower, const double upper);
+
+  /**
+   * @brief Maps to 10^U(log10(lower), log10(upper))
+   * */
+  void logUniform(double* values, const int n, const double lower, const double upper);
+
+  /**
+   * @brief Maps to N(mean, std) truncated to [a, b], as
+   * truncated_normal_ab_cdf_inv()
+   * */
+  void truncatedNormal(double* values, const int n, const double mean,
+      const double std, const double a, const double b);
+
+  /**
+   * @brief Maps to 10^N(mean, std) truncated to [10^a, 10^b]
+   * */
+  void truncatedLogNormal(double* values, const int n, const double mean,
+      const double std, const double a, const double b);
+
+  /**
+   * @brief Maps through a table of quantiles of the probabilities
+   * j/(size-1), interpolating linearly, see InputTabulated
+   * */
+  void tabulated(double* values, const int n, const double* table, const int size);
+
+  /**
+   * @brief Raises 10 to the values
+   * */
+  void pow10(double* values, const int n);
+
+  /**
+   * @brief Maps probabilities in (0,1) to standard normal deviates, as
+   * normal_01_cdf_inv()
+   * */
+  void normal01(double* values, const int n);
+}
+
+BIO_NAMESPACE_END
+
+#endif   /* ----- #ifndef InverseCDF_INC  ----- */
@@ -21,6 +21,14 @@ class Jansen : public SASimple
     int getNumSamples() const override;
     void sample() override;
     void estimate() override;
+    /**
+     * @brief Estimates the indices from resampled steps of the winding stairs
+     *
+     * @param units indexes of the r+1 steps
+     * @param sens matrix to hold the indices
+     * @param check throws if too many simulations have failed
+     * */
+    void estimate(const int* units, DMatrix& sens, const bool check);
 
     int r_;
 };
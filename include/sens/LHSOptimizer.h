@@ -0,0 +1,82 @@
+/**
+ @file LHSOptimizer.h
+ @brief Improves the space filling of a Latin hypercube
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#ifndef  LHSOptimizer_INC
+#define  LHSOptimizer_INC
+
+#include <chrono>
+#include <vector>
+
+#include "Matrix.h"
+#include "RNGWrapper.h"
+
+BIO_NAMESPACE_BEGIN
+
+/**
+ * @brief Simulated annealing of a Latin hypercube on the maximin criterion.
+ *
+ * The criterion is phi_p = (sum over pairs of d_ij^-p)^(1/p) of \cite
+ * Morris1995, which orders designs as their smallest distance d_ij does for
+ * a large p, then by the number of pairs at that distance. A move exchanges
+ * two values of a column, so the design stays a Latin hypercube; only the
+ * 2(n-1) pairs of the two rows change, the sum is updated from these pairs
+ * in O(n*k).
+ * */
+class LHSOptimizer
+{
+  public:
+    typedef std::chrono::steady_clock::time_point Deadline_t;
+
+    /**
+     * @brief Constructor, computes the criterion of the design in O(n^2*k)
+     *
+     * @param mat the Latin hypercube on [0,1]^k to improve
+     * @param deadline time to stop computing the criterion at, the design is
+     * then left as it is
+     * @param p exponent of the criterion
+     * */
+    LHSOptimizer(const DMatrix& mat, const Deadline_t& deadline = Deadline_t::max(),
+        const int p = 50);
+
+    /**
+     * @brief Returns the criterion phi_p of the current design, infinite if
+     * the constructor ran past its deadline
+     * */
+    double getCriterion() const;
+
+    /**
+     * @brief Copies the current design to @param mat
+     * */
+    void getDesign(DMatrix& mat) const;
+
+    /**
+     * @brief Anneals the design
+     *
+     * @param rng the stream of the moves
+     * @param iterations number of proposed exchanges
+     * @param deadline time to stop at even if iterations remain
+     * @return the number of exchanges proposed
+     * */
+    int optimize(RNGStream& rng, const int iterations, const Deadline_t& deadline);
+  private:
+    /**
+     * @brief Returns the sum of d_ij^-p between row i and the other rows,
+     * skipping row @param skip
+     * */
+    double rowSum(const int i, const int skip) const;
+
+    int m_NumRows;
+    int m_NumCols;
+    int m_Power;
+    double m_Scale;                             /* distances in units of n^(-1/k) */
+    std::vector<double> m_Design;               /* row by row */
+    double m_Sum;                               /* sum of d_ij^-p over pairs */
+    bool m_Complete;                            /* m_Sum computed before the deadline? */
+};
+
+BIO_NAMESPACE_END
+
+#endif   /* ----- #ifndef LHSOptimizer_INC  ----- */
@@ -14,6 +14,7 @@
 #include <iomanip>
 #include <memory>
 #include <ostream>
+#include <functional>
 #include <stdexcept>
 
 #include "common/namespace.h"
@@ -167,6 +168,13 @@ template <typename T> class Matrix
     { 
       return m_Data; 
     }
+    /**
+     * @brief Returns the const row vector
+     * */
+    const T* const* getData() const
+    {
+      return m_Data;
+    }
 
     /**
      * @brief Copies content
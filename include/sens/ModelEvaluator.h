@@ -8,6 +8,7 @@
 #ifndef  ModelEvaluator_INC
 #define  ModelEvaluator_INC
 #include "common/namespace.h"
+#include "common/CancelToken.h"
 
 BIO_NAMESPACE_BEGIN
 
@@ -18,14 +19,57 @@ class ModelEvaluator
     virtual ~ModelEvaluator();
 
     virtual int solve(const double* inputs, double* outputs) const = 0;
+
+    /**
+     * @brief Evaluates the model on a block of samples
+     *
+     * The default implementation calls solve() on each sample. Evaluators
+     * may override it to vectorize across samples or to share setup costs
+     * within the block.
+     *
+     * Each sample gets a fresh time budget on the cancel token. A failed
+     * sample is labeled SIM_TIMEOUT if its budget has run out and
+     * SIM_CANCELLED if the token has been cancelled; samples left after a
+     * cancellation are not solved.
+     *
+     * @param inputs rows of input values, one per sample
+     * @param outputs rows (allocated by callers) to hold the output values
+     * @param labels vector (allocated by callers) to hold SIM_SUCCESS,
+     * SIM_FAILURE, SIM_TIMEOUT or SIM_CANCELLED for each sample
+     * @param num number of samples in the block
+     * */
+    virtual void solveBatch(const double* const* inputs, double* const* outputs,
+        int* labels, const int num) const;
     
     int getNumInputs() const;
     int getNumOutputs() const;
     void setUserData(void* data);
+
+    /**
+     * @brief Sets the wall-clock time budget of a sample
+     *
+     * @param seconds the budget, a non-positive value means unlimited
+     * */
+    void setTimeBudget(const double seconds);
+
+    /**
+     * @brief Links the cancel token to a run-wide token
+     *
+     * @param parent a token whose cancellation stops this evaluator
+     * */
+    void setParentToken(const CancelToken* parent);
+
+    /**
+     * @brief Returns the token that solve() should poll, e.g. by passing it to
+     * the ODE solver
+     * */
+    const CancelToken* getCancelToken() const;
   protected:
     int m_NumInputs;
     int m_NumOutputs;
     void* m_UserData;
+    double m_TimeBudget;                        /* per sample time budget in seconds */
+    mutable CancelToken m_Token;                /* rearmed before each sample */
 };
 
 BIO_NAMESPACE_END
@@ -39,10 +39,24 @@ class ModelInput
     const InputDist* getDist() const;
     ModelInput& setUniform(const double lower, const double upper);
     ModelInput& setNormal(const double mean, const double std);
+    ModelInput& setLogNormal(const double mu, const double sigma);
+    ModelInput& setTriangular(const double lower, const double mode, const double upper);
+    ModelInput& setBeta(const double alpha, const double beta,
+        const double lower = 0, const double upper = 1);
+    ModelInput& setPiecewiseLinear(const std::vector<double>& xs,
+        const std::vector<double>& densities);
+    ModelInput& setEmpirical(const std::vector<double>& samples);
 
     int getIndex() const;
     ModelInput& setIndex(const int index);
 
+    /**
+     * @brief Puts the input in the group @param group, analysed as one
+     * factor by grouped methods, see ModelInputList::getGroups()
+     * */
+    const std::string& getGroup() const;
+    ModelInput& setGroup(const std::string& group);
+
   protected:
     std::string m_Name;
     int m_Index;
@@ -50,6 +64,7 @@ class ModelInput
     bool   m_HasRef;
     int m_Count;
     bool   m_Log;
+    std::string m_Group;                        /* empty if the input is alone */
 
     InputDist* m_Dist;
   private:
@@ -67,6 +82,19 @@ class ModelInputList
     const ModelInput* get(const std::string& name) const;
     const ModelInput* get(const int index) const;
     int size() const;
+
+    /**
+     * @brief Returns the indexes of the inputs of each group
+     *
+     * Groups are numbered in the order of their first input, an input
+     * without group is a group of its own.
+     * */
+    std::vector<std::vector<int> > getGroups() const;
+    /**
+     * @brief Returns the name of the group @param index of getGroups(), the
+     * name of the input for an input without group
+     * */
+    std::string getGroupName(const int index) const;
   protected:
     std::vector<std::unique_ptr<ModelInput> > m_List;
     
@@ -7,6 +7,8 @@
 #ifndef  Morris_INC
 #define  Morris_INC
 
+#include <vector>
+
 #include "SASimple.h"
 
 BIO_NAMESPACE_BEGIN
@@ -31,14 +33,50 @@ class Morris : public SASimple
      * @param p number of grid levels 
      * */
     void setP(const int p);
+
+    /**
+     * @brief Draws the trajectories from a pool of candidates
+     *
+     * The r trajectories kept are the most spread over the input space, as
+     * in \cite Campolongo2007, selected by removing one by one the candidate
+     * closest to the others, see \cite Ruano2012. Only the kept trajectories
+     * are simulated.
+     *
+     * @param num number of candidates, no selection if not larger than r
+     * */
+    void setCandidates(const int num);
   private:
     int getNumSens() const override;
     int getNumSamples() const override;
     void sample() override;
     void estimate() override;
+    /**
+     * @brief Estimates the measures from resampled trajectories
+     *
+     * @param units indexes of the r trajectories
+     * @param sens matrix to hold the measures
+     * @param check throws if too many simulations have failed
+     * */
+    void estimate(const int* units, DMatrix& sens, const bool check);
+    /**
+     * @brief Computes the distances between trajectories
+     *
+     * The distance of two trajectories is the sum of the euclidean
+     * distances between their points.
+     *
+     * @param x the trajectories, k+1 rows each
+     * @param dist square matrix to hold the distances, one row per
+     * trajectory
+     * */
+    void distances(const DMatrix& x, DMatrix& dist) const;
+    /**
+     * @brief Returns the indexes of the r trajectories kept, increasing
+     * */
+    std::vector<int> select(const DMatrix& dist) const;
 
     int r_;                                     /* number of trajectories */
     int p_;                                     /* number of grid levels */
+    int candidates_;                            /* trajectories drawn before selection */
     std::unique_ptr<IMatrix> perm_;             /* array of permutation vectors used to generate Bstar matrix */
 };
 
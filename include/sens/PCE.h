@@ -0,0 +1,134 @@
+/**
+ @file PCE.h
+ @brief Sobol indices of a polynomial chaos expansion
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#ifndef  PCE_INC
+#define  PCE_INC
+
+#include <utility>
+#include <vector>
+
+#include "SABase.h"
+
+BIO_NAMESPACE_BEGIN
+
+/**
+ * @brief Sobol indices read from a sparse polynomial chaos expansion of the
+ * model, see \cite Sudret2008 and \cite Blatman2011.
+ *
+ * Each input is represented by a germ with an orthonormal family of
+ * polynomials: Hermite polynomials of a standard normal germ for
+ * DIST_NORMAL inputs, Legendre polynomials of a germ uniform on [-1,1] for
+ * DIST_UNIFORM inputs. Other inputs are represented by Legendre polynomials
+ * of their probability. The normal inputs are truncated at 3 standard
+ * deviations, which the Hermite polynomials ignore: the expansion is then
+ * within a few percent of orthonormal.
+ *
+ * The candidate basis holds the products of univariate polynomials whose
+ * degrees d have a q-norm (sum d_i^q)^(1/q) at most the degree of the
+ * expansion. The N samples of the design, drawn following the sampling
+ * method, are simulated once. Terms are then selected among the candidates
+ * by orthogonal matching pursuit, each output on its own: the term most
+ * correlated with the residual joins the expansion and the coefficients are
+ * refitted by least squares. The expansion kept is the one with the
+ * smallest leave-one-out error, the pursuit stops once ten terms in a row
+ * have not lowered it.
+ *
+ * The variance of an expansion is the sum of its squared coefficients but
+ * the constant, so every Sobol index is a sum of squared coefficients: the
+ * first order index of a factor sums the terms of this factor alone, its
+ * total index all terms involving it. For every output the indices of a
+ * factor are the first order and total indices, NaN if the expansion has
+ * no variance. Bootstrap replicates refit the selected terms on the
+ * resampled samples.
+ * */
+class PCE : public SABase
+{
+  public:
+    PCE();
+    /**
+     * @brief Sets the number of simulated samples
+     *
+     * @param N number of samples, at least 2
+     * */
+    void setN(const int N);
+    /**
+     * @brief Sets the maximal degree of the expansion
+     *
+     * @param degree the degree, at least 1
+     * */
+    void setDegree(const int degree);
+    /**
+     * @brief Sets the q-norm truncating the candidate basis
+     *
+     * Values below 1 drop the terms of high interaction order first.
+     *
+     * @param q the norm in (0,1], 1 keeps all terms up to the degree
+     * */
+    void setQNorm(const double q);
+    /**
+     * @brief Returns the second order indices S_ij
+     *
+     * Row p holds the pair p in the order (0,1), (0,2), ..., (0,k-1),
+     * (1,2), ..., column j the output j.
+     *
+     * @return the indices, nullptr before the first analysis
+     * */
+    const DMatrix* getSens2() const;
+    /**
+     * @brief Returns the leave-one-out errors of the expansions relative to
+     * the variances of the outputs, one per output
+     * */
+    const std::vector<double>& getLOOError() const;
+  private:
+    /* a term of the expansion as (input, degree) pairs of its non zero
+     * degrees */
+    typedef std::vector<std::pair<int, int> > Term_t;
+
+    int getNumSens() const override;
+    void doSA() override;
+    void sample();
+    /**
+     * @brief Fills basis_ with the candidate terms, the constant first
+     * */
+    void buildBasis();
+    /**
+     * @brief Fills psi_ with the candidate terms evaluated at the germs of
+     * the valid samples
+     *
+     * @param unit the design on the unit hypercube, before its conversion to
+     * the input distributions
+     * */
+    void evalBasis(const DMatrix& unit);
+    /**
+     * @brief Selects the terms of the expansion of @param iOut
+     *
+     * @param y the output at the valid samples
+     * */
+    void select(const int iOut, const std::vector<double>& y);
+    /**
+     * @brief Writes the indices of an expansion in @param sens
+     *
+     * @param coefs coefficients of the terms selected for @param iOut
+     * @param sens2 matrix to hold the second order indices, may be null
+     * */
+    void indices(const int iOut, const std::vector<double>& coefs,
+        DMatrix& sens, DMatrix* sens2) const;
+
+    int N_;                                     /* number of simulated samples */
+    int degree_;
+    double qNorm_;
+    std::vector<Term_t> basis_;                 /* candidate terms */
+    std::vector<int> valid_;                    /* rows of the valid samples */
+    std::vector<double> psi_;                   /* candidate terms at the valid samples, column by column */
+    std::vector<std::vector<int> > terms_;      /* selected terms per output */
+    std::vector<std::vector<double> > coefs_;   /* their coefficients */
+    std::vector<double> loo_;                   /* relative leave-one-out errors */
+    std::unique_ptr<DMatrix> sens2_;
+};
+
+BIO_NAMESPACE_END
+
+#endif   /* ----- #ifndef PCE_INC  ----- */
@@ -8,15 +8,68 @@
 #define  RNGWrapper_INC
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include<random>
+#include <string>
+#include <vector>
 
 #include "Matrix.h"
+#include "SobolEngine.h"
 
 BIO_NAMESPACE_BEGIN
 
 class ModelInputList;
 
+/**
+ * @brief A sequence of random numbers handed out by RNGWrapper
+ *
+ * Once RNGWrapper::setSeed() has been called, a stream is a Philox4x32-10
+ * counter-based generator \cite Salmon2011: the n-th number of a stream is
+ * a function of the seed, the stream identifier and n only. Streams are
+ * thus independent of each other and may be consumed on any thread, in any
+ * order.
+ *
+ * Without seed, every stream draws from the Mersenne twister of the wrapper,
+ * streams must then be consumed one after the other.
+ *
+ * A stream is a uniform random bit generator, it can be passed to the
+ * distributions of the standard library.
+ * */
+class RNGStream
+{
+  public:
+    typedef uint64_t result_type;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~(result_type) 0; }
+    result_type operator()();
+
+    /**
+     * @brief Returns a number uniformly distributed on [0,1)
+     * */
+    double rand();
+    void rand(double* values, const int num);
+    void rand(const int lower, const int upper, int* values, const int num);
+    void shuffle(int* values, const int num);
+    /**
+     * @brief See RNGWrapper::randomLHS() and RNGWrapper::centerLHS()
+     * */
+    void randomLHS(double* values, const int n);
+    void centerLHS(double* values, const int n);
+  private:
+    friend class RNGWrapper;
+    RNGStream(std::mt19937_64* engine);
+    RNGStream(const uint64_t seed, const uint32_t family, const uint64_t id);
+    void setPosition(const uint64_t position);
+    void refill();
+
+    std::mt19937_64* m_Engine;                  /* nullptr for a counter-based stream */
+    uint32_t m_Key[2];
+    uint32_t m_Counter[4];                      /* block, family, identifier */
+    uint32_t m_Block[4];                        /* the last generated block */
+    uint64_t m_Position;                        /* numbers drawn so far */
+};
+
 class RNGWrapper
 {
   public:
@@ -55,13 +108,58 @@ class RNGWrapper
      * */
     void LHS(DMatrix& mat, const bool random = true);
     void LHS(DMatrix& mat, const ModelInputList* inputs, const bool random = true);
+    /**
+     * @brief Samples @param mat with a Latin hypercube optimized for space
+     * filling, see LHSOptimizer
+     *
+     * A few annealing chains start from their own random Latin hypercubes
+     * and the best final design is kept. The chains run in parallel with
+     * counter-based streams; their number is fixed so that the design does
+     * not depend on the number of threads.
+     *
+     * @param iterations number of exchanges proposed by each chain
+     * @param budget time limit of the optimization in seconds, 0 for none.
+     * A design stopped by the budget depends on the speed of the machine.
+     * */
+    void optimizedLHS(DMatrix& mat, const int iterations, const double budget);
 //    std::unique_ptr<DMatrix> LHS(const ModelInputList* inputs, const int n, const bool random = true);
 //    std::unique_ptr<DMatrix> LHS(const int rows, const int cols, const bool random = true);
 
+    /**
+     * @brief Fills the rows of @param mat with the next points of the Sobol
+     * sequence, the position is kept from one call to the next
+     * */
     void sobol(DMatrix& mat);
     void sobol(DMatrix& mat, const ModelInputList* inputs);
+    /**
+     * @brief Sets the index of the next Sobol point and restarts the
+     * scrambled sequences with a new scrambling
+     * */
+    void setSobolIndex(const unsigned long long index);
+    /**
+     * @brief Makes sobol() return scrambled points
+     *
+     * Row i of the scrambled design is the point i/R of replicate i%R, where
+     * each of the R replicates is the Sobol sequence, from its first point,
+     * under its own nested uniform scrambling. The scramblings are drawn
+     * once after setSobolIndex(), so consecutive calls extend the same
+     * replicates.
+     *
+     * @param replicates number of replicates R, 0 for plain Sobol points
+     * */
+    void setScrambling(const int replicates);
     void MC(DMatrix& mat);
     void MC(DMatrix& mat, const ModelInputList* inputs);
+    /**
+     * @brief Fills @param mat with the rows from @param firstRow of the
+     * Monte Carlo design of the family of streams @param draw
+     *
+     * With a seed, MC(mat) is MC(mat, draw, 0) on a new family, so a design
+     * may be generated in blocks of rows in any order. Not available
+     * without seed.
+     * */
+    void MC(DMatrix& mat, const unsigned long long draw,
+        const unsigned long long firstRow);
 //    std::unique_ptr<DMatrix> sobol(const int rows, const int cols);
 //    std::unique_ptr<DMatrix> sobol(const ModelInputList* inputs, const int n);
 
@@ -97,11 +195,73 @@ class RNGWrapper
     /* Convert a matrix generated with lhs/sobol to target distributions*/
     void convert(DMatrix& mat, const ModelInputList* inputs);
     std::unique_ptr<DMatrix> convertCopy(const DMatrix& mat, const ModelInputList* inputs);
+
+    /**
+     * @brief Switches to counter-based streams derived from @param seed
+     *
+     * Every number drawn afterwards, by the wrapper or by its streams, only
+     * depends on the seed and on the order of the calls on the generation
+     * thread: designs are reproducible and do not depend on the number of
+     * threads.
+     * */
+    void setSeed(const unsigned long long seed);
+    bool isSeeded() const;
+
+    /**
+     * @brief Sets the number of threads used to generate a design, only
+     * effective with counter-based streams
+     * */
+    void setNumThreads(const int num);
+    /**
+     * @brief Returns the number of threads that may consume streams at once,
+     * 1 without seed
+     * */
+    int getNumThreads() const;
+
+    /**
+     * @brief Starts a new family of streams
+     *
+     * A design calls it once then takes one stream per row, column or
+     * trajectory with getStream(), so that two designs never share a stream.
+     * */
+    void nextDraw();
+    /**
+     * @brief Returns the index of the current family of streams
+     * */
+    unsigned long long getDraw() const;
+    /**
+     * @brief Returns the stream @param id of the current family
+     * */
+    RNGStream getStream(const unsigned long long id);
+
+    /**
+     * @brief Serializes the state of the generators, including the position
+     * in the Sobol sequence
+     * */
+    std::string getState() const;
+
+    /**
+     * @brief Restores a state returned by getState()
+     * */
+    void setState(const std::string& state);
   private:
     RNGWrapper(const RNGWrapper& other) = delete;
     RNGWrapper& operator=(const RNGWrapper& other) = delete;
+    void scrambledSobol(DMatrix& mat);
     std::mt19937_64 rng_;
     std::uniform_real_distribution<> urd_;
+    bool seeded_;                               /* counter-based streams? */
+    unsigned long long seed_;
+    unsigned long long draw_;                   /* index of the current family of streams */
+    int numThreads_;
+    RNGStream main_;                            /* stream of the wrapper itself */
+    std::unique_ptr<SobolEngine> sobol_;
+    unsigned long long sobolIndex_;             /* index of the next Sobol point */
+    int replicates_;                            /* scrambled replicates, 0 if not scrambled */
+    bool scrambled_;                            /* scrambling seed drawn? */
+    unsigned long long scrambleSeed_;
+    unsigned long long scrambledRow_;           /* next row of the scrambled design */
+    std::vector<std::unique_ptr<SobolEngine> > replicas_;
 
 };
 
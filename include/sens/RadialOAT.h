@@ -0,0 +1,61 @@
+/**
+ @file RadialOAT.h
+ @brief Radial one-at-a-time design
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#ifndef  RadialOAT_INC
+#define  RadialOAT_INC
+
+#include "SASimple.h"
+
+BIO_NAMESPACE_BEGIN
+
+/**
+ * @brief Screening and total indices from one radial design, see \cite
+ * Campolongo2011.
+ *
+ * The design has r base points a_j and r auxiliary points b_j drawn together
+ * as the two halves of a 2k-dimensional sample, following the sampling
+ * method. Each base point is simulated with its k neighbours, in which the
+ * value of one factor is taken from the auxiliary point, so the r*(k+1)
+ * samples give r elementary effects per factor, all steps from a shared base
+ * point.
+ *
+ * For every output the measures of a factor are mu, mu* and sigma of the
+ * elementary effects, on the unit hypercube as in Morris, then the total
+ * index of Jansen, the mean squared step of the output over twice the output
+ * variance. The variance is estimated from all simulated samples, which are
+ * all distributed as the inputs.
+ * */
+class RadialOAT : public SASimple
+{
+  public:
+    RadialOAT();
+    /**
+     * @brief Sets the number of base points
+     *
+     * @param r number of base points, at least 2
+     * */
+    void setR(const int r);
+  private:
+    int getNumSens() const override;
+    int getNumSamples() const override;
+    void sample() override;
+    void estimate() override;
+    /**
+     * @brief Estimates the measures from resampled base points
+     *
+     * @param units indexes of the r base points
+     * @param sens matrix to hold the measures
+     * @param check throws if too many simulations have failed
+     * */
+    void estimate(const int* units, DMatrix& sens, const bool check);
+
+    int r_;                                     /* number of base points */
+    std::unique_ptr<DMatrix> pilot_;            /* base and auxiliary points on the unit hypercube */
+};
+
+BIO_NAMESPACE_END
+
+#endif   /* ----- #ifndef RadialOAT_INC  ----- */
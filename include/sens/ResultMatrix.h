@@ -14,6 +14,8 @@ BIO_NAMESPACE_BEGIN
 
 #define SIM_SUCCESS 1
 #define SIM_FAILURE 0
+#define SIM_TIMEOUT 2                           /* failure: the sample ran past its time budget */
+#define SIM_CANCELLED 3                         /* failure: the sample was cancelled */
 
 class ResultMatrix : public DMatrix
 {
@@ -21,6 +23,7 @@ class ResultMatrix : public DMatrix
     ResultMatrix(const int nouts, const int nsamples);
     ~ResultMatrix();
     int* getLabels() { return m_Labels; }
+    const int* getLabels() const { return m_Labels; }
 
     std::unique_ptr<ResultMatrix> subMatrix(const int startRow, const int nrows);
   protected:
@@ -15,6 +15,9 @@
 #include "FAST.h"
 #include "EFAST.h"
 #include "RBD.h"
+#include "RadialOAT.h"
+#include "GivenData.h"
+#include "PCE.h"
 
 #endif   /* ----- #ifndef SA_INC  ----- */
 
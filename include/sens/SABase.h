@@ -10,9 +10,15 @@
 
 #include <memory>
 #include <functional>
+#include <string>
 
 #include "common/namespace.h"
 #include "common/Logger.h"
+#include "common/CancelToken.h"
+#include "Checkpoint.h"
+#include "CostModel.h"
+#include "DesignRows.h"
+#include "EvalCache.h"
 #include "ModelEvaluator.h"
 #include "ModelInput.h"
 #include "ResultMatrix.h"
@@ -25,9 +31,31 @@ typedef enum
 {
   SOBOL_SAMPLING=0,
   LHS_SAMPLING,
-  MC_SAMPLING
+  MC_SAMPLING,
+  SCRAMBLED_SOBOL_SAMPLING,                     /* Owen-scrambled sobol sequence */
+  OPTIMIZED_LHS_SAMPLING                        /* maximin Latin hypercube */
 } SamplingMethod_t;
 
+typedef enum
+{
+  SCHEDULE_FIFO=0,                              /* in the order of the samples */
+  SCHEDULE_LONGEST_FIRST                        /* by decreasing predicted cost */
+} Schedule_t;
+
+/**
+ * @brief Makespans of the simulations of an analysis, summed over all calls
+ * to simulate()
+ *
+ * The predicted makespans replay the measured costs of the samples on the
+ * threads, they tell how much the chosen order gains over the FIFO order.
+ * */
+typedef struct
+{
+  double makespan;                              /* measured wall-clock time */
+  double fifoMakespan;                          /* predicted in FIFO order */
+  double scheduledMakespan;                     /* predicted in the order used */
+} ScheduleStats_t;
+
 typedef enum
 {
   SA_REGIONAL = 0,
@@ -38,7 +66,10 @@ typedef enum
   SA_DGSM,
   SA_FAST,
   SA_EFAST,
-  SA_RBD
+  SA_RBD,
+  SA_RADIAL,
+  SA_GIVEN_DATA,
+  SA_PCE
 } SAMethod_t;
 
 
@@ -49,18 +80,182 @@ class SABase
     virtual ~SABase();
 
     void setSamplingMethod(const SamplingMethod_t method);
+    /**
+     * @brief Sets the number of leading points of the Sobol sequence which
+     * are skipped, every analysis starts at this index
+     * */
     void setSobolSkip(const unsigned int skip);
+    /**
+     * @brief Makes the analysis reproducible
+     *
+     * Every analysis then draws its random numbers from counter-based
+     * streams derived from @param seed, the designs are the same at any
+     * number of threads and are generated on these threads.
+     * */
+    void setSeed(const unsigned long long seed);
     void setFailureRate(const double rate);
     void setModelInputList(const ModelInputList* list);
     void setNumOutputs(const int num);
     void setEval(std::function< std::shared_ptr<ModelEvaluator> (void*)> eval);
+    /**
+     * @brief Sets the number of threads used to evaluate the model
+     *
+     * Each thread gets its own evaluator from the factory given to setEval().
+     *
+     * @param num number of threads, 0 means one per hardware thread
+     * */
+    void setNumThreads(const int num);
+    /**
+     * @brief Sets the number of consecutive samples a thread takes at once
+     *
+     * The samples are passed together to ModelEvaluator::solveBatch().
+     *
+     * @param size the chunk size
+     * */
+    void setChunkSize(const int size);
+    /**
+     * @brief Sets the order in which the samples are dispatched to the threads
+     *
+     * SCHEDULE_LONGEST_FIRST starts with the samples predicted to be the
+     * most expensive so that no long simulation is left for the end. Costs
+     * come from the hint given to setCostHint() or, without hint, from the
+     * measured costs of the nearest samples simulated so far, the samples
+     * of a chunk are then timed one by one instead of as one batch.
+     *
+     * @param schedule the order
+     * */
+    void setSchedule(const Schedule_t schedule);
+    /**
+     * @brief Sets a cheap predictor of the cost of simulating a sample
+     *
+     * @param hint returns a relative cost for the model inputs, nullptr to
+     * learn the costs from the simulations
+     * */
+    void setCostHint(std::function<double (const double* inputs)> hint);
+    /**
+     * @brief Returns the makespans of the last analysis
+     * */
+    const ScheduleStats_t& getScheduleStats() const;
+    /**
+     * @brief Sets the wall-clock time budget of a model evaluation
+     *
+     * A sample running past its budget is labeled SIM_TIMEOUT, which counts
+     * as a failure. Evaluators stop early if they poll
+     * ModelEvaluator::getCancelToken().
+     *
+     * @param seconds the budget, 0 means unlimited
+     * */
+    void setTimeBudget(const double seconds);
+    /**
+     * @brief Sets the optimization of OPTIMIZED_LHS_SAMPLING designs, see
+     * RNGWrapper::optimizedLHS()
+     *
+     * @param iterations number of exchanges proposed per annealing chain
+     * @param seconds time limit of the optimization of a design, 0 means
+     * unlimited. A limited optimization is not reproducible, nor resumable
+     * from a checkpoint.
+     * */
+    void setLHSOptimization(const int iterations, const double seconds);
+    /**
+     * @brief Cancels the running analyze() call
+     *
+     * Can be called from any thread. Pending samples are labeled
+     * SIM_CANCELLED and analyze() throws an SAException.
+     * */
+    void cancel();
+    /**
+     * @brief Sets a cache of model evaluations
+     *
+     * Samples found in the cache are not simulated again. The same cache
+     * may be given to several analyses of the same model.
+     *
+     * @param cache the cache, nullptr to simulate every sample
+     * */
+    void setCache(std::shared_ptr<EvalCache> cache);
+    /**
+     * @brief Sets a file recording the progress of analyze()
+     *
+     * Every analyze() call starts a new log in the file, which resume() can
+     * continue after the process has been stopped.
+     *
+     * @param path the checkpoint file, empty to disable checkpointing
+     * */
+    void setCheckpoint(const std::string& path);
+    /**
+     * @brief Enables bootstrap confidence intervals of the indices
+     *
+     * The units of the design (samples, trajectories or search curves) are
+     * resampled with replacement and the indices are re-estimated from the
+     * simulation results, the replicates are evaluated in parallel.
+     *
+     * @param num number of bootstrap replicates, 0 disables bootstrapping
+     * @param level confidence level of the intervals
+     * */
+    void setBootstrap(const int num, const double level = 0.95);
     void analyze();
+    /**
+     * @brief Continues an analysis stopped while checkpointing to a file
+     *
+     * The analysis must be configured as in the stopped run. Rows completed
+     * in the stopped run are not simulated again, the remaining ones are
+     * appended to the same file.
+     *
+     * @param path the checkpoint file
+     * */
+    void resume(const std::string& path);
 
     const DMatrix* getSens() const;
+    /**
+     * @brief Returns the bootstrap confidence intervals of the indices
+     *
+     * Columns 2j and 2j+1 hold the lower and upper bounds of column j of
+     * getSens().
+     *
+     * @return the intervals, nullptr if they have not been estimated
+     * */
+    const DMatrix* getSensCI() const;
+    /**
+     * @brief Returns the samples of the last analysis, nullptr if they have
+     * not been kept (see the setSaveInput() of the methods which have one)
+     * */
+    const DMatrix* getInputData() const;
+    /**
+     * @brief Returns the simulation results of the samples of the last
+     * analysis, nullptr if they have not been kept
+     * */
+    const ResultMatrix* getOutputData() const;
   protected:
     void simulate(const DMatrix& inputs, ResultMatrix& outputs);
+    /**
+     * @brief Simulates a design whose rows may be composed when they are
+     * read, a batch at a time, so that the design is never materialized
+     * */
+    void simulate(const DesignRows& inputs, ResultMatrix& outputs);
+    /**
+     * @brief Fills @param mat with a Latin hypercube on [0,1], optimized with
+     * OPTIMIZED_LHS_SAMPLING
+     * */
+    void sampleLHS(DMatrix& mat);
+
+    /**
+     * @brief Estimates the indices of all factors from a resample
+     *
+     * @param units indexes of the resampled units, the same number as in
+     * the design
+     * @param sens a matrix shaped as m_Sens to hold the indices
+     * */
+    typedef std::function<void (const int* units, DMatrix& sens)> Statistic_t;
+
+    /**
+     * @brief Estimates m_SensCI by bootstrapping a statistic
+     *
+     * @param num number of units of the design
+     * @param statistic the estimator, called concurrently
+     * */
+    void bootstrap(const int num, Statistic_t statistic);
 
     std::unique_ptr<DMatrix> m_Sens;
+    std::unique_ptr<DMatrix> m_SensCI;
     std::unique_ptr<DMatrix> m_InputData;
     std::unique_ptr<ResultMatrix> m_OutputData;
     const ModelInputList* m_InputList;
@@ -70,10 +265,35 @@ class SABase
     int m_Method;
     int m_Sampling;
     unsigned int m_SobolSkip;
+    bool m_Seeded;                              /* counter-based random streams? */
+    unsigned long long m_Seed;
     double m_FailureRate;
+    int m_NumThreads;                           /* number of evaluation threads */
+    int m_ChunkSize;                            /* samples handed to a thread at once */
+    double m_TimeBudget;                        /* per sample time budget in seconds */
+    int m_LHSIterations;                        /* exchanges per chain of an optimized LHS */
+    double m_LHSBudget;                         /* time limit of an optimized LHS in seconds */
+    CancelToken m_Cancel;                       /* run-wide cancel token */
+    std::shared_ptr<EvalCache> m_Cache;         /* evaluation cache, may be null */
+    std::string m_CheckpointPath;               /* empty if not checkpointing */
+    std::unique_ptr<Checkpoint> m_Checkpoint;   /* log of the running analysis */
+    int m_Wave;                                 /* index of the next simulate() call */
+    int m_NumBoot;                              /* number of bootstrap replicates */
+    int m_Schedule;                             /* dispatch order of the samples */
+    std::function<double (const double*)> m_CostHint;
+    CostModel m_CostModel;                      /* measured costs of the samples */
+    ScheduleStats_t m_ScheduleStats;
+    double m_Level;                             /* confidence level of the intervals */
   private:
     std::function< std::shared_ptr<ModelEvaluator> (void* )> m_Eval;
+    void run(const bool resume);
+    void schedule(const DesignRows& inputs, std::vector<int>& order) const;
     virtual int getNumSens() const = 0;
+    /**
+     * @brief Returns the number of rows of the indices, one per input by
+     * default
+     * */
+    virtual int getNumFactors() const;
     virtual void doSA() = 0;
 };
 
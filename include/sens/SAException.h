@@ -32,7 +32,30 @@ enum
   ERROR_RBD_SMALL_SAMPLE_SIZE,
   ERROR_RBD_NONE_POSITIVE_OMEGA,
   ERROR_MORRIS_TOO_SMALL_P,
-  ERROR_MORRIS_TOO_SMALL_R
+  ERROR_MORRIS_TOO_SMALL_R,
+  ERROR_NEGATIVE_NUM_THREADS,
+  ERROR_NONE_POSITIVE_CHUNK_SIZE,
+  ERROR_NEGATIVE_PIPELINE_DEPTH,
+  ERROR_NEGATIVE_TIME_BUDGET,
+  ERROR_ANALYSIS_CANCELLED,
+  ERROR_CACHE_FILE_ACCESS,
+  ERROR_CACHE_FILE_MISMATCH,
+  ERROR_CACHE_SIZE_MISMATCH,
+  ERROR_CHECKPOINT_FILE_ACCESS,
+  ERROR_CHECKPOINT_MISMATCH,
+  ERROR_NEGATIVE_TOLERANCE,
+  ERROR_NEGATIVE_NUM_BOOTSTRAP,
+  ERROR_INVALID_CONFIDENCE_LEVEL,
+  ERROR_SOBOL_EXHAUSTED,
+  ERROR_NONE_POSITIVE_NUM_REPLICATES,
+  ERROR_NEGATIVE_LHS_OPTIMIZATION,
+  ERROR_NEGATIVE_STREAM_BLOCK,
+  ERROR_UNSEEDED_RANDOM_ACCESS,
+  ERROR_NEGATIVE_MORRIS_CANDIDATES,
+  ERROR_NEGATIVE_NUM_BINS,
+  ERROR_GIVEN_DATA_MISMATCH,
+  ERROR_NONE_POSITIVE_PCE_DEGREE,
+  ERROR_INVALID_PCE_QNORM
 } SAExceptionCode_t;
 class SAException : public std::exception
 {
@@ -18,9 +18,87 @@ class SALessSimple : public SABase
     SALessSimple(const SAMethod_t method);
     void setSaveInput(const bool save);
     void setSaveOutput(const bool save);
+    /**
+     * @brief Evaluates the whole design in one call to simulate()
+     *
+     * By default the design is simulated piece by piece (per factor, per
+     * search curve), with a barrier after each piece. In single wave mode
+     * all the pieces are generated up front and simulated together, which
+     * keeps the evaluation threads busy at the cost of holding the whole
+     * design in memory. Estimates are the same in both modes.
+     *
+     * @param single true to evaluate the design in a single wave
+     * */
+    void setSingleWave(const bool single);
+    /**
+     * @brief Overlaps sample generation, simulation and estimation
+     *
+     * The design is cut into pieces (per factor, per search curve). With a
+     * positive depth, a piece is generated while the previous one is being
+     * simulated and the one before is being estimated. At most depth+2
+     * pieces are held in memory at once.
+     *
+     * @param depth number of pieces buffered between stages, 0 runs the
+     * stages one after another
+     * */
+    void setPipelineDepth(const int depth);
+    /**
+     * @brief Generates and simulates the pieces of the design in blocks of
+     * rows
+     *
+     * The rows of a block are generated on demand from the state of the
+     * generator and their index, so at most a block of each matrix of the
+     * design is held instead of the whole matrices. Estimates are the same
+     * as without blocks. Streaming needs designs addressable by row: Sobol
+     * and seeded Monte Carlo samples, search curves, perturbations of a
+     * base sample. It is off when input or output data are saved or in
+     * single wave mode, which need the whole design.
+     *
+     * @param rows number of rows of a block, 0 holds whole pieces
+     * */
+    void setStreamBlock(const int rows);
   protected:
+    /**
+     * @brief A pipeline stage working on a piece of the design
+     *
+     * @param piece index of the piece, stages see pieces in increasing order
+     * @param slot index of the buffer holding the piece, in [0, getNumSlots())
+     * */
+    typedef std::function<void (const int piece, const int slot)> Stage_t;
+
+    /**
+     * @brief Returns the number of buffers needed to run a pipeline
+     * */
+    int getNumSlots() const;
+
+    /**
+     * @brief Returns the number of rows of a streamed block, 0 if pieces
+     * are held whole
+     * */
+    int getStreamBlock() const;
+
+    /**
+     * @brief Runs pieces of the design through generation, evaluation and
+     * estimation stages
+     *
+     * Each stage runs on its own thread and hands pieces to the next one
+     * through a bounded queue; the evaluation stage runs on the calling
+     * thread. A slot is reused only after its piece has been estimated.
+     * The first exception thrown by a stage stops the pipeline and is
+     * rethrown.
+     *
+     * @param num number of pieces
+     * @param produce generates the inputs of a piece
+     * @param evaluate simulates a piece
+     * @param consume estimates from the outputs of a piece
+     * */
+    void pipeline(const int num, Stage_t produce, Stage_t evaluate, Stage_t consume);
+
     bool m_SaveInput;                           /* Save model input data? */
     bool m_SaveOutput;                          /* Save model output data? */
+    bool m_SingleWave;                          /* Simulate the whole design at once? */
+    int m_PipelineDepth;                        /* Pieces buffered between pipeline stages */
+    int m_StreamBlock;                          /* Rows generated at once, 0 for whole pieces */
 };
 
 BIO_NAMESPACE_END
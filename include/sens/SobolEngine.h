@@ -0,0 +1,89 @@
+/**
+ @file SobolEngine.h
+ @brief A Gray-code generator of the Sobol sequence
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#ifndef  SobolEngine_INC
+#define  SobolEngine_INC
+
+#include <cstdint>
+#include <vector>
+
+#include "common/namespace.h"
+
+BIO_NAMESPACE_BEGIN
+
+/**
+ * @brief Generates the Sobol sequence in Gray-code order, see \cite
+ * Antonov1979 and \cite JoeKuo2008.
+ *
+ * Points are 32-bit: the sequence has 2^32 points, each coordinate is a
+ * multiple of 2^-32. Consecutive points differ by one direction number per
+ * dimension, so a point costs one XOR per coordinate. Any point is reached
+ * directly from its index by skipTo().
+ *
+ * The dimensions use the primitive polynomials and the initial direction
+ * numbers of Joe and Kuo. Only the first 3667 dimensions of their table are
+ * embedded, which bounds the number of dimensions.
+ *
+ * setScrambling() applies a nested uniform (Owen) scrambling to the
+ * coordinates, see \cite Owen1995: each point becomes uniformly distributed
+ * while the set keeps the stratification of the sequence, so independent
+ * scramblings give unbiased replicates of a QMC estimate.
+ * */
+class SobolEngine
+{
+  public:
+    /* the number of dimensions of the embedded Joe-Kuo table */
+    static const int MAX_DIMENSION = 3667;
+
+    /**
+     * @brief Constructor, starts at index 0
+     *
+     * @param dims number of dimensions, in [1, MAX_DIMENSION]
+     * */
+    SobolEngine(const int dims);
+
+    int getNumDims() const;
+
+    /**
+     * @brief Returns the index of the next point
+     * */
+    uint64_t getIndex() const;
+
+    /**
+     * @brief Moves to the point @param index, in O(dims*log(index))
+     * */
+    void skipTo(const uint64_t index);
+
+    /**
+     * @brief Writes the next point to @param point and moves on
+     * */
+    void next(double* point);
+
+    /**
+     * @brief Writes the @param num next points to the rows @param points
+     * */
+    void generate(double* const* points, const int num);
+
+    /**
+     * @brief Scrambles the following points with a nested uniform scrambling
+     * drawn from @param seed
+     *
+     * The permutations are hashed from the seed and the digits, as in \cite
+     * Laine2011, so they cost a few multiplications per coordinate. Scrambled
+     * coordinates are centred in their cell of width 2^-32 and never 0.
+     * */
+    void setScrambling(const uint64_t seed);
+  private:
+    int m_NumDims;
+    uint64_t m_Index;
+    std::vector<uint32_t> m_Directions;         /* direction numbers, bit by bit */
+    std::vector<uint32_t> m_Point;              /* current point, as integers */
+    std::vector<uint32_t> m_Seeds;              /* scrambling seed per dimension, empty if not scrambled */
+};
+
+BIO_NAMESPACE_END
+
+#endif   /* ----- #ifndef SobolEngine_INC  ----- */
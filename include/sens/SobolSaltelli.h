@@ -7,6 +7,8 @@
 #ifndef  SobolSaltelli_INC
 #define  SobolSaltelli_INC
 
+#include <vector>
+
 #include "SALessSimple.h"
 
 BIO_NAMESPACE_BEGIN
@@ -22,7 +24,13 @@ BIO_NAMESPACE_BEGIN
  * However the equation for the calculation of the total sensitivity indices are
  * slightly different.
  *
- * 
+ * In the adaptive mode the design is extended in blocks, continuing the same
+ * sampling sequence, until the indices are accurate enough. The estimates
+ * are updated from sums accumulated over all blocks.
+ *
+ * With SCRAMBLED_SOBOL_SAMPLING the design interleaves R independently
+ * scrambled Sobol sequences. The indices are estimated from all samples and
+ * their standard errors from the spread of the R replicate estimates.
  */
 class SobolSaltelli : public SALessSimple
 {
@@ -40,12 +48,191 @@ class SobolSaltelli : public SALessSimple
    * */
     void setN(const int n);
     void setEstimator(const SobolEstimator_t type);
+    /**
+     * @brief Enables the adaptive sample size
+     *
+     * The analysis starts with the number of samples given to setN() and
+     * doubles it until the 95% asymptotic confidence intervals of all first
+     * order and total indices are within +/- tolerance, or maxN samples have
+     * been used. Saved input/output data then hold the blocks one after the
+     * other, each laid out as [a; b; c_1; ...; c_k] then [d_1; ...; d_k]
+     * with second order indices.
+     *
+     * @param tolerance half width of the confidence intervals, 0 disables
+     * the adaptive mode
+     * @param maxN maximum number of samples
+     * */
+    void setAdaptive(const double tolerance, const int maxN);
+    /**
+     * @brief Returns the number of samples used by the last analysis
+     * */
+    int getNumSamples() const;
+    /**
+     * @brief Sets the number of scrambled replicates, only used with
+     * SCRAMBLED_SOBOL_SAMPLING
+     *
+     * Sample i of the design belongs to replicate i%R, so the number of
+     * samples is best a multiple of R. With R>1 the adaptive mode stops on
+     * the replicate standard errors instead of the asymptotic intervals.
+     *
+     * @param r number of replicates R, at least 1
+     * */
+    void setReplicates(const int r);
+    /**
+     * @brief Returns the standard errors of the indices, shaped as getSens()
+     *
+     * @return the standard errors over the replicates, nullptr without
+     * replicates
+     * */
+    const DMatrix* getSensStdErr() const;
+    /**
+     * @brief Enables the second order indices, see \cite Saltelli2002
+     *
+     * Every block of the design gets the matrices d_i, a with column i
+     * from b, after the c_i: [a; b; c_1; ...; c_k; d_1; ...; d_k], so the
+     * design has (2k+2)N samples instead of (k+2)N. Samples of d_i and c_j
+     * share the factors i and j only, their outputs give the closed index
+     * of the pair. The outputs of all c_i and d_i of a block are kept until
+     * the pairs are estimated. The second order indices have no confidence
+     * intervals.
+     * */
+    void setSecondOrder(const bool enable);
+    /**
+     * @brief Returns the second order indices S_ij
+     *
+     * Row p holds the pair p in the order (0,1), (0,2), ..., (0,k-1),
+     * (1,2), ..., column j the output j.
+     *
+     * @return the indices, nullptr if they have not been estimated
+     * */
+    const DMatrix* getSens2() const;
+    /**
+     * @brief Estimates the indices of the groups of inputs instead of the
+     * inputs, see ModelInputList::getGroups()
+     *
+     * The matrix c_g takes all columns of group g from a, so the design has
+     * (g+2)N samples for g groups. Row g of getSens() then holds the first
+     * order and total indices of group g; the first order index of a group
+     * is the closed index of its inputs, interactions within the group
+     * included. Second order indices are those of the pairs of groups.
+     * */
+    void setGrouped(const bool grouped);
   private:
+    /**
+     * @brief Sums over the samples for a factor and an output
+     * */
+    typedef struct
+    {
+      int cnt[3];                               /* number of valid samples */
+      double ya;                                /* ya */
+      double yaya;                              /* ya^2 */
+      double dy;                                /* (yc-yb)*ya */
+      double dydy;                              /* its square */
+      double st;                                /* the total effect term */
+      double stst;                              /* its square */
+    } Sums_t;
+
     int getNumSens() const override;
+    int getNumFactors() const override;
     void doSA() override;
+    /**
+     * @brief Samples and simulates a block of the design then accumulates
+     * its sums
+     *
+     * @param N number of samples of the block
+     * @param x the whole design of the block if saved, nullptr otherwise
+     * @param y outputs of the whole design if saved, nullptr otherwise
+     * */
+    void simulateBlock(const int N, std::unique_ptr<DMatrix>& x,
+        std::unique_ptr<ResultMatrix>& y);
+    /**
+     * @brief Samples and simulates consecutive samples of a block then
+     * accumulates their sums
+     *
+     * @param N number of samples
+     * @param begin index of the first sample in the block
+     * @param x the whole design of the samples if saved, nullptr otherwise
+     * @param y outputs of the whole design if saved, nullptr otherwise
+     * */
+    void simulateRows(const int N, const int begin, std::unique_ptr<DMatrix>& x,
+        std::unique_ptr<ResultMatrix>& y);
+    /**
+     * @brief Accumulates the squared differences of the outputs of the
+     * pairs
+     *
+     * @param ys outputs of c_1, ..., c_k then of d_1, ..., d_k
+     * */
+    void accumulatePairs(std::vector<std::unique_ptr<ResultMatrix> >& ys);
+    /**
+     * @brief Returns the number of matrices of the design, a and b
+     * included
+     * */
+    int getNumMatrices() const;
+    /**
+     * @brief Returns the number of replicates estimated separately, 0 if
+     * none
+     * */
+    int getNumReplicates() const;
+    /**
+     * @brief Accumulates the sums of a factor for all outputs
+     *
+     * @param iK index of the factor
+     * @param ya outputs of the pilot matrix a
+     * @param yb outputs of the pilot matrix b
+     * @param yc outputs of the matrix c for the factor
+     * */
+    void accumulate(const int iK, ResultMatrix& ya, ResultMatrix& yb, ResultMatrix& yc);
+    /**
+     * @brief Estimates the sensitivity indices from the accumulated sums
+     *
+     * @param N number of samples accumulated
+     * @return the largest half width of the 95% confidence intervals
+     * */
+    double estimate(const int N);
+    /**
+     * @brief Estimates the standard errors from the replicate sums
+     *
+     * @return the largest standard error
+     * */
+    double estimateStdErr();
+    /**
+     * @brief Computes S and St of a factor and an output from their sums
+     *
+     * @param sums the sums
+     * @param sens pointer to S, followed by St
+     * @return the output variance D
+     * */
+    double indices(const Sums_t& sums, double* sens) const;
+    /**
+     * @brief Estimates the indices from resampled samples of the kept terms
+     *
+     * @param units indexes of the resampled samples
+     * @param sens matrix to hold the indices
+     * */
+    void resample(const int* units, DMatrix& sens) const;
     
     int N_;
     SobolEstimator_t estimator_;
+    double tolerance_;                          /* adaptive mode if positive */
+    int maxN_;                                  /* sample limit of the adaptive mode */
+    int usedN_;                                 /* samples used by the last analysis */
+    int firstRow_;                              /* index of the first sample being accumulated */
+    unsigned long long mcDraw_;                 /* streams of a, then b, of a seeded MC block */
+    std::vector<Sums_t> sums_;                  /* per factor and output */
+    int replicates_;
+    std::vector<Sums_t> repSums_;               /* per replicate, factor and output */
+    std::unique_ptr<DMatrix> stdErr_;
+    /* per sample terms ya, (yc-yb)*ya and the total effect term, kept for
+     * bootstrapping, interleaved per factor and output */
+    std::vector<std::vector<double> > terms_;
+    /* per sample validity of the three terms (bits 0, 1 and 2) per factor */
+    std::vector<std::vector<char> > masks_;
+    bool secondOrder_;
+    std::vector<double> pairSums_;              /* squared differences per pair and output */
+    std::vector<int> pairCnts_;                 /* valid differences per pair */
+    std::unique_ptr<DMatrix> sens2_;
+    bool grouped_;
+    std::vector<std::vector<int> > factorCols_; /* inputs of each factor or group */
 };
 
 BIO_NAMESPACE_END
@@ -0,0 +1,96 @@
+/**
+ @file WorkerPool.h
+ @brief A small work-stealing pool for evaluating rows of a design matrix
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#ifndef  WorkerPool_INC
+#define  WorkerPool_INC
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/namespace.h"
+
+BIO_NAMESPACE_BEGIN
+
+/**
+ * @brief Runs a task over the index range [0,n) using a fixed number of
+ * workers.
+ *
+ * The range is cut into chunks which are dealt out to per-worker queues. A
+ * worker takes chunks from the front of its own queue; when it runs dry it
+ * steals from the back of the other queues. Since every chunk is executed
+ * exactly once, results written by index do not depend on the number of
+ * workers.
+ *
+ * Worker 0 runs on the calling thread. The first exception thrown by a task
+ * stops the remaining chunks from being handed out and is rethrown by run().
+ * */
+class WorkerPool
+{
+  public:
+    /**
+     * @brief A task executed on a chunk
+     *
+     * @param worker index of the worker executing the chunk, in [0, nthreads)
+     * @param begin first index of the chunk
+     * @param end one past the last index of the chunk
+     * */
+    typedef std::function<void (const int worker, const int begin, const int end)> Task_t;
+
+    /**
+     * @brief Constructor
+     *
+     * @param nthreads number of workers, 0 means one per hardware thread
+     * */
+    WorkerPool(const int nthreads);
+
+    int getNumThreads() const;
+
+    /**
+     * @brief Deals the chunks round-robin instead of in contiguous blocks
+     *
+     * Every worker then starts with one of the first chunks of the range,
+     * which suits ranges sorted by decreasing cost.
+     *
+     * @param interleaved true to deal round-robin
+     * */
+    void setInterleaved(const bool interleaved);
+
+    /**
+     * @brief Executes a task on all indexes in [0,n)
+     *
+     * @param n size of the index range
+     * @param chunk number of consecutive indexes handed out at once
+     * @param task the task to be executed
+     * */
+    void run(const int n, const int chunk, Task_t task);
+
+    /**
+     * @brief Returns the number of hardware threads (at least 1)
+     * */
+    static int getHardwareThreads();
+  private:
+    struct Queue
+    {
+      std::mutex lock;
+      std::deque<int> chunks;                   /* indexes of the chunks */
+    };
+
+    bool next(const int worker, int& chunk);
+
+    int m_NumThreads;
+    bool m_Interleaved;                         /* deals chunks round-robin? */
+    std::vector<std::unique_ptr<Queue> > m_Queues;
+
+    WorkerPool(const WorkerPool& other) = delete;
+    WorkerPool& operator=(const WorkerPool& other) = delete;
+};
+
+BIO_NAMESPACE_END
+
+#endif   /* ----- #ifndef WorkerPool_INC  ----- */
@@ -40,6 +40,11 @@ class CvodeSolver : public SolverBase
                                                    */ 
     void* cvode_;
   private:
+    /* right hand side and root functions polling the cancel token before
+     * calling the helper */
+    static int f(realtype t, N_Vector y, N_Vector ydot, void *f_data);
+    static int g(realtype t, N_Vector y, realtype* gout, void *g_data);
+
     static void errorHandler(int error_code
         , const char* module, const char* function
         , char* msg, void* eh_data);
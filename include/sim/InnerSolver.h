@@ -15,6 +15,7 @@ class Solver;
 class SolverSettings;
 class SolverData;
 class OdeStruct;
+class CancelToken;
 class InnerSolver
 {
   public:
@@ -28,6 +29,7 @@ class InnerSolver
   protected:
     const SolverSettings* getSettings() const;
     const OdeStruct* getModel();
+    const CancelToken* getCancelToken() const;
     void setInitialCondition();
     virtual void doInitialize() = 0;
     virtual void doReset() = 0;
@@ -16,6 +16,7 @@
 
 BIO_NAMESPACE_BEGIN
 
+class CancelToken;
 
 class Solver
 {
@@ -27,6 +28,16 @@ class Solver
     void reset();
     void reset(const std::vector<int>& indexes, const double* values);
     void solve(const double time);
+    /**
+     * @brief Sets a token to be polled during integration
+     *
+     * Once the token is stopped, solve() throws an ErrorList whose error code
+     * is the token status (ERROR_TIME_BUDGET_EXCEEDED or
+     * ERROR_SIMULATION_CANCELLED).
+     *
+     * @param token the token, nullptr to integrate without checks
+     * */
+    void setCancelToken(const CancelToken* token);
     const double* getValues() const { return m_Data->getValues(); }
   protected:
 
@@ -35,6 +46,7 @@ class Solver
     std::unique_ptr<SolverData> m_Data;
     std::unique_ptr<CvodeSolver1> m_Solver;
     ErrorList m_Errors;
+    const CancelToken* m_Token;
 
   private:
     void checkErrors();
@@ -20,6 +20,7 @@ BIO_NAMESPACE_BEGIN
 class OdeModel;
 class SolverSettings;
 class SolverHelper;
+class CancelToken;
 
 class SolverBase
 {
@@ -93,6 +94,16 @@ class SolverBase
      */
     virtual int solve(const double endTime) = 0;
 
+    /**
+     * @brief Sets a token to be polled during integration
+     *
+     * Once the token is stopped, solve() gives up and returns the token
+     * status (ERROR_TIME_BUDGET_EXCEEDED or ERROR_SIMULATION_CANCELLED).
+     *
+     * @param token the token, nullptr to integrate without checks
+     * */
+    void setCancelToken(const CancelToken* token);
+
     /**
      * @brief Gets current simulation result values for all model's variables*/
     const double* getValues() const;
@@ -133,6 +144,8 @@ class SolverBase
     
     double m_CurrentTime;                       /**< A time value indicates where solver currently reaches  */
 
+    const CancelToken* m_Token;                 /**< A token polled during integration */
+
   private:
 
 };
@@ -0,0 +1,66 @@
+/**
+ @file CancelToken.cpp
+ @brief Implementation for CancelToken class
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#include "CancelToken.h"
+
+#include "CommonDefs.h"
+
+BIO_NAMESPACE_BEGIN
+
+CancelToken::CancelToken(const CancelToken* parent)
+  : m_Cancelled(false)
+  , m_Parent(parent)
+  , m_HasDeadline(false)
+{
+}
+
+void CancelToken::setParent(const CancelToken* parent)
+{
+  m_Parent = parent;
+}
+
+void CancelToken::cancel()
+{
+  m_Cancelled = true;
+}
+
+void CancelToken::reset()
+{
+  m_Cancelled = false;
+  m_HasDeadline = false;
+}
+
+void CancelToken::setBudget(const double seconds)
+{
+  m_HasDeadline = seconds > 0;
+  if (m_HasDeadline)
+  {
+    m_Deadline = std::chrono::steady_clock::now()
+      + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(seconds));
+  }
+}
+
+bool CancelToken::isCancelled() const
+{
+  return m_Cancelled || (m_Parent && m_Parent->isCancelled());
+}
+
+bool CancelToken::isStopped() const
+{
+  return getStatus() != SATOOLS_SUCCESS;
+}
+
+int CancelToken::getStatus() const
+{
+  if (isCancelled())
+    return ERROR_SIMULATION_CANCELLED;
+  if (m_HasDeadline && std::chrono::steady_clock::now() >= m_Deadline)
+    return ERROR_TIME_BUDGET_EXCEEDED;
+  return SATOOLS_SUCCESS;
+}
+
+BIO_NAMESPACE_END
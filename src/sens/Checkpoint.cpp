@@ -0,0 +1,305 @@
+/**
+ @file Checkpoint.cpp
+ @brief Implementation for Checkpoint class
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#include "Checkpoint.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SAException.h"
+
+BIO_NAMESPACE_BEGIN
+
+namespace
+{
+  const char CHECKPOINT_MAGIC[8] = {'S', 'A', 'C', 'K', 'P', 'T', '0', '1'};
+
+  enum
+  {
+    RECORD_STATE = 1,
+    RECORD_WAVE,
+    RECORD_ROWS
+  };
+
+  struct CheckpointHeader
+  {
+    char magic[8];
+    int32_t numInputs;
+    int32_t numOutputs;
+    int32_t method;
+    int32_t reserved;
+    int64_t length;                             /* bytes of valid records */
+  };
+
+  /* every record is a head followed by a payload padded to 8 bytes */
+  struct RecordHead
+  {
+    int32_t type;
+    int32_t wave;
+    int32_t begin;
+    int32_t count;
+    int64_t bytes;
+  };
+
+  size_t padded(const size_t bytes)
+  {
+    return (bytes + 7) & ~((size_t) 7);
+  }
+
+  /* the map grows by at least this amount */
+  const size_t MIN_GROWTH = 1 << 20;
+}
+
+Checkpoint::Checkpoint(const std::string& path, const int nInputs,
+    const int nOutputs, const int method, const bool resume)
+  : m_NumInputs(nInputs)
+  , m_NumOutputs(nOutputs)
+  , m_File(-1)
+  , m_Map(nullptr)
+  , m_MapSize(0)
+  , m_Length(0)
+{
+  int flags = resume ? O_RDWR : O_RDWR | O_CREAT | O_TRUNC;
+  m_File = open(path.c_str(), flags, 0644);
+  if (m_File<0)
+    throw SAException(ERROR_CHECKPOINT_FILE_ACCESS);
+
+  struct stat st;
+  if (fstat(m_File, &st)!=0)
+  {
+    close();
+    throw SAException(ERROR_CHECKPOINT_FILE_ACCESS);
+  }
+
+  /* 1. A new log only has a header */
+  if (!resume)
+  {
+    try
+    {
+      reserve(MIN_GROWTH);
+    } catch (...)
+    {
+      close();
+      throw;
+    }
+    CheckpointHeader* header = (CheckpointHeader*) m_Map;
+    memcpy(header->magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header->numInputs = nInputs;
+    header->numOutputs = nOutputs;
+    header->method = method;
+    header->reserved = 0;
+    header->length = 0;
+    m_Length = sizeof(CheckpointHeader);
+    return;
+  }
+
+  /* 2. An existing log must belong to the same analysis */
+  m_MapSize = st.st_size;
+  void* map = m_MapSize>=sizeof(CheckpointHeader)
+    ? mmap(nullptr, m_MapSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_File, 0)
+    : MAP_FAILED;
+  if (map==MAP_FAILED)
+  {
+    m_MapSize = 0;
+    close();
+    throw SAException(ERROR_CHECKPOINT_MISMATCH);
+  }
+  m_Map = (char*) map;
+  const CheckpointHeader* header = (const CheckpointHeader*) m_Map;
+  if (memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC))!=0
+      || header->numInputs!=nInputs || header->numOutputs!=nOutputs
+      || header->method!=method || header->length<0
+      || sizeof(CheckpointHeader) + header->length>m_MapSize)
+  {
+    close();
+    throw SAException(ERROR_CHECKPOINT_MISMATCH);
+  }
+  m_Length = sizeof(CheckpointHeader) + header->length;
+  load();
+}
+
+Checkpoint::~Checkpoint()
+{
+  close();
+}
+
+void Checkpoint::close()
+{
+  if (m_Map)
+    munmap(m_Map, m_MapSize);
+  m_Map = nullptr;
+  if (m_File>=0)
+    ::close(m_File);
+  m_File = -1;
+}
+
+void Checkpoint::load()
+{
+  size_t offset = sizeof(CheckpointHeader);
+  while (offset<m_Length)
+  {
+    const RecordHead* head = (const RecordHead*) (m_Map + offset);
+    const char* payload = m_Map + offset + sizeof(RecordHead);
+    switch (head->type)
+    {
+      case RECORD_STATE:
+        m_State.assign(payload, head->count);
+        break;
+      case RECORD_WAVE:
+        m_Waves[head->wave] = offset;
+        break;
+      case RECORD_ROWS:
+        m_Rows[head->wave].push_back(offset);
+        break;
+    }
+    offset += sizeof(RecordHead) + head->bytes;
+  }
+}
+
+void Checkpoint::reserve(const size_t size)
+{
+  if (size<=m_MapSize)
+    return;
+
+  size_t mapSize = m_MapSize + MIN_GROWTH;
+  if (mapSize<2*m_MapSize)
+    mapSize = 2*m_MapSize;
+  if (mapSize<size)
+    mapSize = size;
+  if (ftruncate(m_File, mapSize)!=0)
+    throw SAException(ERROR_CHECKPOINT_FILE_ACCESS);
+  void* map = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_File, 0);
+  if (map==MAP_FAILED)
+    throw SAException(ERROR_CHECKPOINT_FILE_ACCESS);
+  if (m_Map)
+    munmap(m_Map, m_MapSize);
+  m_Map = (char*) map;
+  m_MapSize = mapSize;
+}
+
+char* Checkpoint::append(const int type, const int wave, const int begin,
+    const int count, const size_t bytes)
+{
+  reserve(m_Length + sizeof(RecordHead) + padded(bytes));
+  RecordHead* head = (RecordHead*) (m_Map + m_Length);
+  head->type = type;
+  head->wave = wave;
+  head->begin = begin;
+  head->count = count;
+  head->bytes = padded(bytes);
+  return m_Map + m_Length + sizeof(RecordHead);
+}
+
+void Checkpoint::commit()
+{
+  const RecordHead* head = (const RecordHead*) (m_Map + m_Length);
+  m_Length += sizeof(RecordHead) + head->bytes;
+  ((CheckpointHeader*) m_Map)->length = m_Length - sizeof(CheckpointHeader);
+}
+
+const std::string& Checkpoint::getState() const
+{
+  return m_State;
+}
+
+void Checkpoint::saveState(const std::string& state)
+{
+  std::lock_guard<std::mutex> lock(m_Lock);
+  char* payload = append(RECORD_STATE, -1, 0, state.size(), state.size());
+  memcpy(payload, state.data(), state.size());
+  commit();
+  m_State = state;
+}
+
+void Checkpoint::beginWave(const int wave, const DesignRows& inputs,
+    ResultMatrix& outputs, std::vector<char>& done)
+{
+  std::lock_guard<std::mutex> lock(m_Lock);
+  int nRows = inputs.getNumRows();
+  size_t rowBytes = sizeof(double)*m_NumInputs;
+  std::vector<double> buf(m_NumInputs);
+  done.assign(nRows, 0);
+
+  /* 1. Record the design of a new wave */
+  auto it = m_Waves.find(wave);
+  if (it==m_Waves.end())
+  {
+    char* payload = append(RECORD_WAVE, wave, 0, nRows, rowBytes*nRows);
+    for (int iRow=0; iRow<nRows; ++iRow)
+      memcpy(payload + rowBytes*iRow, inputs.getRow(iRow, buf.data()), rowBytes);
+    m_Waves[wave] = m_Length;
+    commit();
+    return;
+  }
+
+  /* 2. Otherwise the regenerated design must match the recorded one */
+  const RecordHead* head = (const RecordHead*) (m_Map + it->second);
+  const char* design = m_Map + it->second + sizeof(RecordHead);
+  if (head->count!=nRows)
+    throw SAException(ERROR_CHECKPOINT_MISMATCH);
+  for (int iRow=0; iRow<nRows; ++iRow)
+  {
+    if (memcmp(design + rowBytes*iRow, inputs.getRow(iRow, buf.data()), rowBytes)!=0)
+      throw SAException(ERROR_CHECKPOINT_MISMATCH);
+  }
+
+  /* 3. Restore the completed rows */
+  int* labels = outputs.getLabels();
+  for (size_t offset : m_Rows[wave])
+  {
+    head = (const RecordHead*) (m_Map + offset);
+    const int32_t* ls = (const int32_t*) (m_Map + offset + sizeof(RecordHead));
+    const double* ys = (const double*) ((const char*) ls + padded(sizeof(int32_t)*head->count));
+    for (int i=0; i<head->count; ++i)
+    {
+      int iRow = head->begin + i;
+      labels[iRow] = ls[i];
+      memcpy(outputs.getRow(iRow), ys + m_NumOutputs*i, sizeof(double)*m_NumOutputs);
+      done[iRow] = 1;
+    }
+  }
+}
+
+void Checkpoint::saveRows(const int wave, const int begin, const int count,
+    const double* const* outputs, const int* labels)
+{
+  std::lock_guard<std::mutex> lock(m_Lock);
+  int i = 0;
+  while (i<count)
+  {
+    /* 1. Find the next run of rows with final labels */
+    if (labels[i]!=SIM_SUCCESS && labels[i]!=SIM_FAILURE)
+    {
+      ++i;
+      continue;
+    }
+    int end = i+1;
+    while (end<count && (labels[end]==SIM_SUCCESS || labels[end]==SIM_FAILURE))
+      ++end;
+
+    /* 2. Append it as one record */
+    int n = end-i;
+    size_t labelBytes = padded(sizeof(int32_t)*n);
+    char* payload = append(RECORD_ROWS, wave, begin+i, n,
+        labelBytes + sizeof(double)*m_NumOutputs*n);
+    int32_t* ls = (int32_t*) payload;
+    double* ys = (double*) (payload + labelBytes);
+    for (int j=0; j<n; ++j)
+    {
+      ls[j] = labels[i+j];
+      memcpy(ys + m_NumOutputs*j, outputs[i+j], sizeof(double)*m_NumOutputs);
+    }
+    commit();
+    i = end;
+  }
+}
+
+BIO_NAMESPACE_END
@@ -0,0 +1,102 @@
+/**
+ @file CostModel.cpp
+ @brief Implementation for CostModel class
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#include "CostModel.h"
+
+#include <algorithm>
+#include <limits>
+
+BIO_NAMESPACE_BEGIN
+
+CostModel::CostModel(const int capacity, const int neighbours)
+  : m_Capacity(capacity > 0 ? capacity : 1)
+  , m_Neighbours(neighbours > 0 ? neighbours : 1)
+  , m_NumInputs(0)
+  , m_NumAdded(0)
+{
+}
+
+void CostModel::clear()
+{
+  m_NumInputs = 0;
+  m_NumAdded = 0;
+  m_Inputs.clear();
+  m_Costs.clear();
+  m_Min.clear();
+  m_Max.clear();
+}
+
+bool CostModel::empty() const
+{
+  return m_Costs.empty();
+}
+
+void CostModel::add(const double* inputs, const int nInputs, const double cost)
+{
+  if (m_NumAdded == 0)
+  {
+    m_NumInputs = nInputs;
+    m_Min.assign(inputs, inputs+nInputs);
+    m_Max.assign(inputs, inputs+nInputs);
+  }
+
+  for (int i=0; i<m_NumInputs; ++i)
+  {
+    m_Min[i] = std::min(m_Min[i], inputs[i]);
+    m_Max[i] = std::max(m_Max[i], inputs[i]);
+  }
+
+  /* appends until full, then replaces the oldest sample */
+  if ((int) m_Costs.size() < m_Capacity)
+  {
+    m_Inputs.insert(m_Inputs.end(), inputs, inputs+m_NumInputs);
+    m_Costs.push_back(cost);
+  } else
+  {
+    int slot = m_NumAdded % m_Capacity;
+    std::copy(inputs, inputs+m_NumInputs, &m_Inputs[slot*m_NumInputs]);
+    m_Costs[slot] = cost;
+  }
+  m_NumAdded++;
+}
+
+double CostModel::predict(const double* inputs) const
+{
+  if (m_Costs.empty())
+    return 0;
+
+  /* inverse squared ranges of the inputs */
+  std::vector<double> scales(m_NumInputs);
+  for (int i=0; i<m_NumInputs; ++i)
+  {
+    double range = m_Max[i] - m_Min[i];
+    scales[i] = range > 0 ? 1/(range*range) : 0;
+  }
+
+  /* keeps the nearest samples sorted by distance */
+  int nNear = std::min(m_Neighbours, (int) m_Costs.size());
+  std::vector<std::pair<double, double> > near(nNear,
+      std::make_pair(std::numeric_limits<double>::max(), 0.0));
+  for (size_t iS=0; iS<m_Costs.size(); ++iS)
+  {
+    const double* x = &m_Inputs[iS*m_NumInputs];
+    double dist = 0;
+    for (int i=0; i<m_NumInputs; ++i)
+      dist += (x[i]-inputs[i]) * (x[i]-inputs[i]) * scales[i];
+    if (dist < near.back().first)
+    {
+      near.back() = std::make_pair(dist, m_Costs[iS]);
+      std::sort(near.begin(), near.end());
+    }
+  }
+
+  double cost = 0;
+  for (auto& n : near)
+    cost += n.second;
+  return cost / nNear;
+}
+
+BIO_NAMESPACE_END
@@ -5,6 +5,9 @@
   */
 #include "DGSM.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "SAException.h"
 
 BIO_NAMESPACE_BEGIN
@@ -42,22 +45,30 @@ void DGSM::doSA()
 {
   int k = m_InputList->size();                  /* number of input factors */
 
-  /* 1. Allocates input/output data */
+  /* derivatives are kept for bootstrapping */
+  derivs_.assign(m_NumBoot>0 ? k*m_NumOutputs*N_ : 0, 0);
+  valid_.assign(m_NumBoot>0 ? k*N_ : 0, 0);
+
+  /* 1. Allocates input/output data
+   * xall holds X followed by the k perturbed matrices, it is allocated when
+   * saving data or evaluating in a single wave */
+  std::unique_ptr<DMatrix> xall(nullptr);
+  std::unique_ptr<ResultMatrix> yall(nullptr);
   std::unique_ptr<DMatrix> X(nullptr);
   std::unique_ptr<ResultMatrix> y(nullptr);
-  if (m_SaveInput)
+  if (m_SaveInput || m_SingleWave)
   {
-    m_InputData.reset(new DMatrix(N_*(k+1), k));
-    X = std::move(m_InputData->subMatrix(0, N_));
+    xall.reset(new DMatrix(N_*(k+1), k));
+    X = std::move(xall->subMatrix(0, N_));
   } else
   {
     X.reset(new DMatrix(N_, k));
   }
 
-  if (m_SaveOutput)
+  if (m_SaveOutput || m_SingleWave)
   {
-    m_OutputData.reset(new ResultMatrix(N_*(k+1), m_NumOutputs));
-    y = std::move(m_OutputData->subMatrix(0, N_));
+    yall.reset(new ResultMatrix(N_*(k+1), m_NumOutputs));
+    y = std::move(yall->subMatrix(0, N_));
   } else
   {
     y.reset(new ResultMatrix(N_, m_NumOutputs));
@@ -66,99 +77,222 @@ void DGSM::doSA()
   std::unique_ptr<DMatrix> x(new DMatrix(N_, k));
 
   /* 2. Generates the first N samples */
-  m_RNG.LHS(*x);
+  sampleLHS(*x);
 
   /* Copies then converts to target distributions */
   x->copy(*X);
   m_RNG.convert(*X, m_InputList);
   
-  /* 3. Runs simulation for the first N samples */
-  simulate(*X, *y);
-
-  /* 4. Allocates xdiff, ydiff if needs
-   * xdiff is the 1-column different from X and ydiff is its corresponding
-   * output
-   * */
-  std::unique_ptr<DMatrix> xdiff(nullptr);
-  if (!m_SaveInput)
+  if (m_SingleWave)
   {
-    xdiff.reset(new DMatrix(N_, k));
-  }
+    /* 3. Fills the perturbed matrices then simulates all samples */
+    for (int iK=0; iK<k; ++iK)
+    {
+      std::unique_ptr<DMatrix> xdiff(xall->subMatrix((iK+1)*N_, N_));
+      perturb(*x, *xdiff, iK);
+    }
+    simulate(*xall, *yall);
 
-  std::unique_ptr<ResultMatrix> ydiff(nullptr);
-  if (!m_SaveOutput)
+    /* 4. Estimate sensitivity indices for each input factor */
+    std::vector<double> xcol(N_);
+    for (int iK=0; iK<k; ++iK)
+    {
+      std::unique_ptr<DMatrix> xdiff(xall->subMatrix((iK+1)*N_, N_));
+      std::unique_ptr<ResultMatrix> ydiff(yall->subMatrix((iK+1)*N_, N_));
+      xdiff->copyCol(iK, xcol.data());
+      estimate(iK, *X, *y, xcol.data(), *ydiff);
+    }
+  } else if (getStreamBlock()>0 && getStreamBlock()<N_)
   {
-    ydiff.reset(new ResultMatrix(N_, m_NumOutputs));
-  }
+    /* 3. Runs simulation for the first N samples */
+    simulate(*X, *y);
 
-  std::unique_ptr<DMatrix> stats(new DMatrix(3, m_NumOutputs));
-  
-  const int* labels = y->getLabels();
+    /* 4. The perturbed matrices are generated and simulated a block of rows
+     * at a time, only their perturbed column and outputs are held whole */
+    int block = getStreamBlock();
+    int nSlots = getNumSlots();
+    std::vector<std::vector<double> > xcols(nSlots, std::vector<double>(N_));
+    std::vector<std::unique_ptr<ResultMatrix> > ydiffs(nSlots);
+    for (int iSlot=0; iSlot<nSlots; ++iSlot)
+      ydiffs[iSlot].reset(new ResultMatrix(N_, m_NumOutputs));
+    DMatrix xblock(block, k);
 
-  /* 5. Estimate sensitivity indices for each input factor */
-  for (int iK=0; iK<k; ++iK)
+    /* 5. Perturbs and simulates each block then estimates the indices of
+     * each input factor */
+    pipeline(k,
+        [](const int, const int)
+        {
+          /* the rows are generated by the evaluation stage */
+        },
+        [&](const int iK, const int slot)
+        {
+          for (int begin=0; begin<N_; begin+=block)
+          {
+            int n = std::min(block, N_-begin);
+            std::unique_ptr<DMatrix> xrows(x->subMatrix(begin, n));
+            std::unique_ptr<DMatrix> xdiff(xblock.subMatrix(0, n));
+            std::unique_ptr<ResultMatrix> ydiff(ydiffs[slot]->subMatrix(begin, n));
+            perturb(*xrows, *xdiff, iK);
+            xdiff->copyCol(iK, &xcols[slot][begin]);
+            simulate(*xdiff, *ydiff);
+          }
+        },
+        [&](const int iK, const int slot)
+        {
+          estimate(iK, *X, *y, xcols[slot].data(), *ydiffs[slot]);
+        });
+  } else
   {
-    /* Makes xdiff, ydiff refer to their correct location if needs */
-    if (m_SaveInput)
-    {
-      xdiff = std::move(m_InputData->subMatrix((iK+1)*N_, N_));
-    }
+    /* 3. Runs simulation for the first N samples */
+    simulate(*X, *y);
 
-    if (m_SaveOutput)
+    /* 4. Allocates xdiff, ydiff buffers if needs
+     * xdiff is the 1-column different from X and ydiff is its corresponding
+     * output
+     * */
+    int nSlots = getNumSlots();
+    std::vector<std::unique_ptr<DMatrix> > xdiffs(nSlots);
+    std::vector<std::unique_ptr<ResultMatrix> > ydiffs(nSlots);
+    for (int iSlot=0; iSlot<nSlots; ++iSlot)
     {
-      ydiff = std::move(m_OutputData->subMatrix((iK+1)*N_, N_));
+      if (!xall)
+        xdiffs[iSlot].reset(new DMatrix(N_, k));
+      if (!yall)
+        ydiffs[iSlot].reset(new ResultMatrix(N_, m_NumOutputs));
     }
 
-    /* Copy the first N samples to xdiff and diffs the column iK*/
-    x->copy(*xdiff);
-    for (int iRow=0; iRow<N_; ++iRow)
+    /* 5. Fills xdiff, runs simulation then estimates sensitivity indices for
+     * each input factor. xdiff, ydiff refer to their correct location if
+     * data is saved */
+    pipeline(k,
+        [&](const int iK, const int slot)
+        {
+          if (xall)
+            xdiffs[slot] = std::move(xall->subMatrix((iK+1)*N_, N_));
+          perturb(*x, *xdiffs[slot], iK);
+        },
+        [&](const int iK, const int slot)
+        {
+          if (yall)
+            ydiffs[slot] = std::move(yall->subMatrix((iK+1)*N_, N_));
+          simulate(*xdiffs[slot], *ydiffs[slot]);
+        },
+        [&](const int iK, const int slot)
+        {
+          std::vector<double> xcol(N_);
+          xdiffs[slot]->copyCol(iK, xcol.data());
+          estimate(iK, *X, *y, xcol.data(), *ydiffs[slot]);
+        });
+  }
+
+  /* 6. Bootstraps the samples */
+  if (m_NumBoot>0)
+  {
+    bootstrap(N_,
+        [this, k](const int* units, DMatrix& sens)
+        {
+          for (int iK=0; iK<k; ++iK)
+            measure(&derivs_[iK*m_NumOutputs*N_], &valid_[iK*N_], units,
+                sens.getRow(iK), false);
+        });
+  }
+
+  /* 7. Retains input/output data if needs */
+  if (m_SaveInput)
+    m_InputData = std::move(xall);
+  if (m_SaveOutput)
+    m_OutputData = std::move(yall);
+}
+
+void DGSM::estimate(const int iK, DMatrix& X, ResultMatrix& y, const double* xdiff, ResultMatrix& ydiff)
+{
+  const int* labels = y.getLabels();
+  const int* labelsdiff = ydiff.getLabels();    
+
+  /* derivatives of the outputs, located in the kept data if bootstrapping */
+  std::vector<double> localDerivs;
+  std::vector<char> localValid;
+  double* derivs;
+  char* valid;
+  if (m_NumBoot>0)
+  {
+    derivs = &derivs_[iK*m_NumOutputs*N_];
+    valid = &valid_[iK*N_];
+  } else
+  {
+    localDerivs.resize(m_NumOutputs*N_);
+    localValid.resize(N_);
+    derivs = localDerivs.data();
+    valid = localValid.data();
+  }
+
+  for (int iRow = 0; iRow < N_; ++iRow)
+  {
+    valid[iRow] = labels[iRow] == SIM_SUCCESS
+      && labelsdiff[iRow] == SIM_SUCCESS;
+    if (valid[iRow])
     {
-      /* Changes values in column iK */
-      double* row = xdiff->getRow(iRow);
-      if (row[iK] + delta_ >= 1)
-        row[iK] -= delta_;
-      else row[iK] += delta_;
+      const double* yrow = y.getRow(iRow);
+      const double* ydiffrow = ydiff.getRow(iRow);
+      double dx = X.getRow(iRow)[iK] - xdiff[iRow];
+      for (int iOut=0; iOut< m_NumOutputs; ++iOut)
+        derivs[iOut*N_ + iRow] = (ydiffrow[iOut] - yrow[iOut]) / dx;
     }
-    
-    /* Converts xdiff to target distributions */
-    m_RNG.convert(*xdiff, m_InputList);
-    
-    /* Runs simulation */
-    simulate(*xdiff, *ydiff);
-
-    
-    /* Estimates sensitivity indices */
-    const int* labelsdiff = ydiff->getLabels();    
-    double* sens = m_Sens->getRow(iK);
-    for (int iOut=0; iOut< m_NumOutputs; ++iOut)
+  }
+
+  std::vector<int> units(N_);
+  for (int iRow = 0; iRow < N_; ++iRow)
+    units[iRow] = iRow;
+  measure(derivs, valid, units.data(), m_Sens->getRow(iK), true);
+}
+
+void DGSM::measure(const double* derivs, const char* valid,
+    const int* units, double* sens, const bool check)
+{
+  for (int iOut=0; iOut< m_NumOutputs; ++iOut)
+  {
+    const double* d = &derivs[iOut*N_];
+    double mean=0, absmean=0, std=0;
+    int cnt = 0;
+    for (int iUnit = 0; iUnit < N_; ++iUnit)
     {
-      double mean=0, absmean=0, std=0;
-      double derivative = 0;
-      int cnt = 0;
-      for (int iRow = 0; iRow < N_; ++iRow)
+      int iRow = units[iUnit];
+      if (valid[iRow])
       {
-        if (labels[iRow] == SIM_SUCCESS
-            && labelsdiff[iRow] == SIM_SUCCESS)
-        {
-          derivative = (ydiff->getRow(iRow)[iOut] - y->getRow(iRow)[iOut])
-                      / (X->getRow(iRow)[iK] - xdiff->getRow(iRow)[iK]);
-          cnt++;
-          mean += derivative;
-          absmean += derivative > 0 ? derivative : -derivative;
-          std += derivative*derivative;
-        }   
-      }
-      if (cnt < N_ * (1-m_FailureRate))
-        throw SAException(ERROR_EXCEEDING_FAILURE_RATE);
-
-      mean /= cnt;
-      absmean /= cnt;
-      std = sqrt(std/cnt - mean*mean);
-      sens[iOut*iK] = mean;
-      sens[iOut*iK+1] = absmean;
-      sens[iOut*iK+2] = std;    
-    } 
+        double derivative = d[iRow];
+        cnt++;
+        mean += derivative;
+        absmean += derivative > 0 ? derivative : -derivative;
+        std += derivative*derivative;
+      }   
+    }
+    if (check && cnt < N_ * (1-m_FailureRate))
+      throw SAException(ERROR_EXCEEDING_FAILURE_RATE);
+
+    mean /= cnt;
+    absmean /= cnt;
+    std = sqrt(std/cnt - mean*mean);
+    sens[3*iOut] = mean;
+    sens[3*iOut+1] = absmean;
+    sens[3*iOut+2] = std;    
+  } 
+}
+
+void DGSM::perturb(DMatrix& x, DMatrix& xdiff, const int col)
+{
+  /* Copy the first N samples to xdiff and diffs the column col */
+  x.copy(xdiff);
+  for (int iRow=0; iRow<x.getNumRows(); ++iRow)
+  {
+    /* Changes values in column col */
+    double* row = xdiff.getRow(iRow);
+    if (row[col] + delta_ >= 1)
+      row[col] -= delta_;
+    else row[col] += delta_;
   }
+
+  /* Converts xdiff to target distributions */
+  m_RNG.convert(xdiff, m_InputList);
 }
 
 BIO_NAMESPACE_END
@@ -0,0 +1,64 @@
+/**
+ @file DesignRows.cpp
+ @brief Implementation for DesignRows classes
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#include "DesignRows.h"
+
+#include <cstring>
+
+BIO_NAMESPACE_BEGIN
+
+DesignRows::~DesignRows()
+{
+}
+
+MatrixRows::MatrixRows(const DMatrix& mat)
+  : m_Matrix(mat)
+{
+}
+
+int MatrixRows::getNumRows() const
+{
+  return m_Matrix.getNumRows();
+}
+
+int MatrixRows::getNumCols() const
+{
+  return m_Matrix.getNumCols();
+}
+
+const double* MatrixRows::getRow(const int iRow, double*) const
+{
+  return m_Matrix.getRow(iRow);
+}
+
+RadialRows::RadialRows(const DMatrix& base, const DMatrix& source,
+    const std::vector<int>& cols)
+  : m_Base(base)
+  , m_Source(source)
+  , m_Cols(cols)
+{
+}
+
+int RadialRows::getNumRows() const
+{
+  return m_Base.getNumRows();
+}
+
+int RadialRows::getNumCols() const
+{
+  return m_Base.getNumCols();
+}
+
+const double* RadialRows::getRow(const int iRow, double* buf) const
+{
+  memcpy(buf, m_Base.getRow(iRow), sizeof(double)*m_Base.getNumCols());
+  const double* source = m_Source.getRow(iRow);
+  for (int col : m_Cols)
+    buf[col] = source[col];
+  return buf;
+}
+
+BIO_NAMESPACE_END
@@ -6,11 +6,14 @@
 
 #include "EFAST.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <memory>
+#include <vector>
 
 #include "SAException.h"
+#include "WorkerPool.h"
 #include "dft.h"
 
 constexpr static double MY_PI = 4.0*atan(1);
@@ -67,31 +70,19 @@ void EFAST::doSA()
   std::unique_ptr<double[]> phis_ptr(new double[k]);
   double* phis = phis_ptr.get();
   
-  /* 5. Allocates input/output data */
+  /* 5. Allocates input/output data
+   * xall holds the search curves of all factors, it is allocated when saving
+   * data or evaluating in a single wave */
+  std::unique_ptr<DMatrix> xall(nullptr);
+  std::unique_ptr<ResultMatrix> yall(nullptr);
 
-  std::unique_ptr<DMatrix> x(nullptr);
-  std::unique_ptr<ResultMatrix> y(new ResultMatrix(1,1));
-
-  double** xdata(nullptr);
-  double** ydata(nullptr);
-  int* labels(nullptr);
-
-  if (m_SaveInput)
-  {
-    m_InputData.reset(new DMatrix(N*Nr_*k, k));
-  } else
+  if (m_SaveInput || m_SingleWave)
   {
-    x.reset(new DMatrix(N, k));
-    xdata = x->getData();
+    xall.reset(new DMatrix(N*Nr_*k, k));
   }
-  if (m_SaveOutput)
-  {
-    m_OutputData.reset(new ResultMatrix(N*Nr_*k, m_NumOutputs));
-  } else
+  if (m_SaveOutput || m_SingleWave)
   {
-    y.reset(new ResultMatrix(N, m_NumOutputs));
-    ydata = y->getData();
-    labels = y->getLabels();
+    yall.reset(new ResultMatrix(N*Nr_*k, m_NumOutputs));
   }
 
   /* 6. Allocates vector to store variances estimated for each search curve */
@@ -103,88 +94,229 @@ void EFAST::doSA()
   std::unique_ptr<double[]> ycol_ptr(new double[N]);
   double* ycol = ycol_ptr.get();
 
-  /* 8. Estimates sensitivity indices */
-  for (int iFactor=0; iFactor<k; ++iFactor)                    /* for each input factor */
+  /* the variances of every search curve are kept for bootstrapping */
+  std::vector<double> curveVariances(m_NumBoot>0 ? 3*k*Nr_*m_NumOutputs : 0);
+
+  /* Accumulates variances of a search curve, estimates sensitivity indices
+   * of the factor after its last curve */
+  auto accumulate = [&](const int iFactor, const int iNr, ResultMatrix& y)
   {
-    for (int iV=0; iV<m_NumOutputs; ++iV)
+    if (iNr == 0)
     {
-      totalV[iV] = 0;
-      totalVi[iV] = 0;
-      totalVci[iV] = 0;
+      for (int iV=0; iV<m_NumOutputs; ++iV)
+      {
+        totalV[iV] = 0;
+        totalVi[iV] = 0;
+        totalVci[iV] = 0;
+      }
     }
 
-    for (int iNr=0; iNr<Nr_; ++iNr)                /* for each search curve */
+    /* Estimates variance */
+    int* labels = y.getLabels();
+    for (int iOut=0; iOut < m_NumOutputs; ++iOut)
     {
-      /* Randomly generate phi values */
-      m_RNG.rand(phis, k);
-      for (int iK=0; iK<k; ++iK)
+      y.copyCol(iOut, ycol);                  /* makes a copy of the column */
+      interpolate(ycol, labels, N);           /* fills missing values */
+      double variances[3] = {0, 0, 0 };
+      if (useFFT_)
+      {
+        fftVariances(ycol, N, omegas[0], variances);
+      } else 
       {
-        phis[iK] *= 2*MY_PI;   
+        directVariances(ycol, s, N, omegas[0], variances);
       }
-      
-      int startId = iFactor*Nr_*N + iNr*N;
 
-      /**
-       * Let x refers to its according submatrix of the allocated input data 
-       * */
-      if (m_SaveInput)
+      totalV[iOut] += variances[0]; 
+      totalVi[iOut] += variances[1];
+      totalVci[iOut] += variances[2];
+      if (m_NumBoot>0)
+        std::copy(variances, variances+3,
+            &curveVariances[3*((iFactor*Nr_ + iNr)*m_NumOutputs + iOut)]);
+    }
+
+    if (iNr == Nr_-1)
+    {
+      /* Estimates sensitivity indices for current factor */
+      double* sens= m_Sens->getRow(iFactor);
+      for (int iOut=0; iOut<m_NumOutputs; ++iOut)
       {
-        x = std::move(m_InputData->subMatrix(startId, N));
-        xdata = x->getData();
+        sens[2*iOut] = totalVi[iOut] / totalV[iOut];
+        sens[2*iOut+1] = 1 - totalVci[iOut] / totalV[iOut];
       }
-      /**
-       * Let y refers to its according submatrix of the allocated output data
-       * */
-      if (m_SaveOutput)
+    }
+  };
+
+  /* each search curve takes its phase shifts from its own stream */
+  m_RNG.nextDraw();
+
+  if (m_SingleWave)
+  {
+    /* 8. Samples all search curves then simulates them at once */
+    WorkerPool pool(m_RNG.getNumThreads());
+    pool.run(k*Nr_, 1, [&](const int, const int begin, const int end)
+        {
+          std::unique_ptr<double[]> curvePhis(new double[k]);
+          for (int iCurve=begin; iCurve<end; ++iCurve)
+          {
+            std::unique_ptr<DMatrix> x(xall->subMatrix(iCurve*N, N));
+            RNGStream rng = m_RNG.getStream(iCurve);
+            sampleCurve(*x, omegas, s, curvePhis.get(), iCurve / Nr_, rng);
+          }
+        });
+    simulate(*xall, *yall);
+
+    /* 9. Estimates sensitivity indices */
+    for (int iFactor=0; iFactor<k; ++iFactor)
+    {
+      for (int iNr=0; iNr<Nr_; ++iNr)
       {
-        y = std::move(m_OutputData->subMatrix(startId, N));
-        ydata = y->getData();
-        labels = y->getLabels();
+        std::unique_ptr<ResultMatrix> y(yall->subMatrix(iFactor*Nr_*N + iNr*N, N));
+        accumulate(iFactor, iNr, *y);
       }
+    }
+  } else if (getStreamBlock()>0 && getStreamBlock()<N)
+  {
+    /* 8. Only the outputs of the search curves are held whole, their points
+     * are generated and simulated a block at a time */
+    int block = getStreamBlock();
+    int nSlots = getNumSlots();
+    std::vector<std::unique_ptr<ResultMatrix> > ys(nSlots);
+    for (int iSlot=0; iSlot<nSlots; ++iSlot)
+      ys[iSlot].reset(new ResultMatrix(N, m_NumOutputs));
+    std::vector<double> slotPhis(nSlots*k);
+    DMatrix xblock(block, k);
+
+    /* 9. Draws the phase shifts, simulates then estimates each search
+     * curve of each factor */
+    pipeline(k*Nr_,
+        [&](const int iCurve, const int slot)
+        {
+          RNGStream rng = m_RNG.getStream(iCurve);
+          drawPhases(&slotPhis[slot*k], rng);
+        },
+        [&](const int iCurve, const int slot)
+        {
+          for (int begin=0; begin<N; begin+=block)
+          {
+            int n = std::min(block, N-begin);
+            std::unique_ptr<DMatrix> x(xblock.subMatrix(0, n));
+            std::unique_ptr<ResultMatrix> y(ys[slot]->subMatrix(begin, n));
+            fillCurve(*x, omegas, s+begin, &slotPhis[slot*k], iCurve / Nr_);
+            simulate(*x, *y);
+          }
+        },
+        [&](const int iCurve, const int slot)
+        {
+          accumulate(iCurve / Nr_, iCurve % Nr_, *ys[slot]);
+        });
+  } else
+  {
+    /* 8. Allocates buffers for search curves, x and y refer to their
+     * according submatrices of the allocated input/output data if any */
+    int nSlots = getNumSlots();
+    std::vector<std::unique_ptr<DMatrix> > xs(nSlots);
+    std::vector<std::unique_ptr<ResultMatrix> > ys(nSlots);
+    for (int iSlot=0; iSlot<nSlots; ++iSlot)
+    {
+      if (!xall)
+        xs[iSlot].reset(new DMatrix(N, k));
+      if (!yall)
+        ys[iSlot].reset(new ResultMatrix(N, m_NumOutputs));
+    }
 
-      /* Do sampling on x */
-      for (int iK=0; iK<k; ++iK)
-      {
-        int omId = (iK + k - iFactor ) % k;  /* index of omega in the vector 'omegas' */
-        for (int iN=0; iN<N; ++iN)
+    /* 9. Samples, simulates then estimates each search curve of each factor */
+    pipeline(k*Nr_,
+        [&](const int iCurve, const int slot)
         {
-          xdata[iN][iK] = 0.5 + asin(sin(omegas[omId]*s[iN] + phis[iK])) / MY_PI;
-        }
-      }
-        
-      /* Converts x data to target distributions */
-      m_RNG.convert(*x, m_InputList);  
-      
-      /* Runs simulations */
-      simulate(*x, *y);
-      
-      /* Estimates variance */
-      for (int iOut=0; iOut < m_NumOutputs; ++iOut)
-      {
-        y->copyCol(iOut, ycol);                 /* makes a copy of the column */
-        interpolate(ycol, labels, N);           /* fills missing values */
-        double variances[3] = {0, 0, 0 };
-        if (useFFT_)
+          if (xall)
+            xs[slot] = std::move(xall->subMatrix(iCurve*N, N));
+          RNGStream rng = m_RNG.getStream(iCurve);
+          sampleCurve(*xs[slot], omegas, s, phis, iCurve / Nr_, rng);
+        },
+        [&](const int iCurve, const int slot)
         {
-          fftVariances(ycol, N, omegas[0], variances);
-        } else 
+          if (yall)
+            ys[slot] = std::move(yall->subMatrix(iCurve*N, N));
+          simulate(*xs[slot], *ys[slot]);
+        },
+        [&](const int iCurve, const int slot)
         {
-          directVariances(ycol, s, N, omegas[0], variances);
-        }
+          accumulate(iCurve / Nr_, iCurve % Nr_, *ys[slot]);
+        });
+  }
 
-        totalV[iOut] += variances[0]; 
-        totalVi[iOut] += variances[1];
-        totalVci[iOut] += variances[2];
-      }
-    }  /* end of a search curve */
-    /* Estimates sensitivity indices for current factor */
-    double* sens= m_Sens->getRow(iFactor);
-    for (int iOut=0; iOut<m_NumOutputs; ++iOut)
+  /* 10. Bootstraps the search curves, each factor takes the same resampled
+   * curve indexes */
+  if (m_NumBoot>0)
+  {
+    bootstrap(Nr_,
+        [&](const int* units, DMatrix& sens)
+        {
+          for (int iFactor=0; iFactor<k; ++iFactor)
+          {
+            double* row = sens.getRow(iFactor);
+            for (int iOut=0; iOut<m_NumOutputs; ++iOut)
+            {
+              double v[3] = {0, 0, 0};
+              for (int iUnit=0; iUnit<Nr_; ++iUnit)
+              {
+                const double* cv = &curveVariances[3*((iFactor*Nr_ + units[iUnit])*m_NumOutputs + iOut)];
+                v[0] += cv[0];
+                v[1] += cv[1];
+                v[2] += cv[2];
+              }
+              row[2*iOut] = v[1] / v[0];
+              row[2*iOut+1] = 1 - v[2] / v[0];
+            }
+          }
+        });
+  }
+
+  /* 11. Retains input/output data if needs */
+  if (m_SaveInput)
+    m_InputData = std::move(xall);
+  if (m_SaveOutput)
+    m_OutputData = std::move(yall);
+}
+
+void EFAST::sampleCurve(DMatrix& x, const int* omegas, const double* s, double* phis, const int iFactor,
+    RNGStream& rng)
+{
+  drawPhases(phis, rng);
+  fillCurve(x, omegas, s, phis, iFactor);
+}
+
+void EFAST::drawPhases(double* phis, RNGStream& rng)
+{
+  int k = m_InputList->size();
+
+  /* Randomly generate phi values */
+  rng.rand(phis, k);
+  for (int iK=0; iK<k; ++iK)
+  {
+    phis[iK] *= 2*MY_PI;   
+  }
+}
+
+void EFAST::fillCurve(DMatrix& x, const int* omegas, const double* s, const double* phis,
+    const int iFactor)
+{
+  int k = m_InputList->size();
+  int N = x.getNumRows();
+  double** xdata = x.getData();
+
+  /* Do sampling on x */
+  for (int iK=0; iK<k; ++iK)
+  {
+    int omId = (iK + k - iFactor ) % k;  /* index of omega in the vector 'omegas' */
+    for (int iN=0; iN<N; ++iN)
     {
-      sens[iOut*m_NumOutputs] = totalVi[iOut] / totalV[iOut];
-      sens[iOut*m_NumOutputs+1] = 1 - totalVci[iOut] / totalV[iOut];
+      xdata[iN][iK] = 0.5 + asin(sin(omegas[omId]*s[iN] + phis[iK])) / MY_PI;
     }
   }
+    
+  /* Converts x data to target distributions */
+  m_RNG.convert(x, m_InputList);  
 }
 
 void EFAST::directVariances(const double* y, const double *s, const int N, const int omega, double* v)
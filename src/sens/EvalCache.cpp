@@ -0,0 +1,310 @@
+/**
+ @file EvalCache.cpp
+ @brief Implementation for EvalCache class
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#include "EvalCache.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ModelEvaluator.h"
+#include "ResultMatrix.h"
+#include "SAException.h"
+
+BIO_NAMESPACE_BEGIN
+
+namespace
+{
+  const char CACHE_MAGIC[8] = {'S', 'A', 'C', 'A', 'C', 'H', 'E', '1'};
+
+  /* the file starts with a header followed by the records */
+  struct CacheHeader
+  {
+    char magic[8];
+    int32_t numInputs;
+    int32_t numOutputs;
+    int64_t size;                               /* number of valid records */
+  };
+
+  /* each record starts with a fixed part followed by the input and output
+   * values */
+  struct RecordHead
+  {
+    uint64_t key;
+    uint64_t fingerprint;
+    int32_t label;
+    int32_t reserved;
+  };
+
+  /* 64-bit FNV-1a */
+  const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+  const uint64_t FNV_PRIME = 1099511628211ULL;
+  uint64_t fnv1a(const void* data, const size_t len, uint64_t h)
+  {
+    const unsigned char* p = (const unsigned char*) data;
+    for (size_t i=0; i<len; ++i)
+    {
+      h ^= p[i];
+      h *= FNV_PRIME;
+    }
+    return h;
+  }
+}
+
+EvalCache::EvalCache(const int nInputs, const int nOutputs,
+    const std::string& fingerprint, const std::string& path)
+  : m_NumInputs(nInputs)
+  , m_NumOutputs(nOutputs)
+  , m_Fingerprint(fnv1a(fingerprint.data(), fingerprint.size(), FNV_OFFSET))
+  , m_RecordSize(sizeof(RecordHead) + sizeof(double)*(nInputs+nOutputs))
+  , m_Size(0)
+  , m_Capacity(0)
+  , m_Records(nullptr)
+  , m_File(-1)
+  , m_Map(nullptr)
+  , m_MapSize(0)
+  , m_Hits(0)
+  , m_Misses(0)
+{
+  if (nInputs<=0)
+    throw SAException(ERROR_NONE_POSITIVE_INPUT_SIZE);
+  if (nOutputs<=0)
+    throw SAException(ERROR_NONE_POSITIVE_OUTPUT_SIZE);
+  if (!path.empty())
+    openFile(path);
+}
+
+EvalCache::~EvalCache()
+{
+  if (m_Map)
+    munmap(m_Map, m_MapSize);
+  if (m_File>=0)
+    close(m_File);
+}
+
+void EvalCache::openFile(const std::string& path)
+{
+  m_File = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (m_File<0)
+    throw SAException(ERROR_CACHE_FILE_ACCESS);
+
+  struct stat st;
+  if (fstat(m_File, &st)!=0)
+  {
+    close(m_File);
+    throw SAException(ERROR_CACHE_FILE_ACCESS);
+  }
+
+  /* 1. A new file only gets a header */
+  size_t fileSize = st.st_size;
+  if (fileSize==0)
+  {
+    fileSize = sizeof(CacheHeader);
+    if (ftruncate(m_File, fileSize)!=0)
+    {
+      close(m_File);
+      throw SAException(ERROR_CACHE_FILE_ACCESS);
+    }
+  }
+
+  /* 2. Map the whole file */
+  void* map = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_File, 0);
+  if (map==MAP_FAILED)
+  {
+    close(m_File);
+    throw SAException(ERROR_CACHE_FILE_ACCESS);
+  }
+  m_Map = (char*) map;
+  m_MapSize = fileSize;
+  m_Records = m_Map + sizeof(CacheHeader);
+  m_Capacity = (fileSize - sizeof(CacheHeader)) / m_RecordSize;
+
+  CacheHeader* header = (CacheHeader*) m_Map;
+  if (st.st_size==0)
+  {
+    memcpy(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header->numInputs = m_NumInputs;
+    header->numOutputs = m_NumOutputs;
+    header->size = 0;
+    return;
+  }
+
+  /* 3. Check an existing file and index its records */
+  if (fileSize<sizeof(CacheHeader)
+      || memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC))!=0
+      || header->numInputs!=m_NumInputs
+      || header->numOutputs!=m_NumOutputs
+      || header->size<0 || header->size>m_Capacity)
+  {
+    munmap(m_Map, m_MapSize);
+    m_Map = nullptr;
+    close(m_File);
+    m_File = -1;
+    throw SAException(ERROR_CACHE_FILE_MISMATCH);
+  }
+  m_Size = header->size;
+  for (int i=0; i<m_Size; ++i)
+  {
+    RecordHead* rec = (RecordHead*) getRecord(i);
+    m_Index.insert(std::make_pair(rec->key, i));
+  }
+}
+
+void EvalCache::reserve(const int capacity)
+{
+  if (m_File<0)
+  {
+    m_Buffer.resize(m_RecordSize*capacity);
+    m_Records = m_Buffer.data();
+    m_Capacity = capacity;
+    return;
+  }
+
+  /* grow the file then remap it, the records are flushed by the kernel */
+  size_t mapSize = sizeof(CacheHeader) + m_RecordSize*capacity;
+  if (ftruncate(m_File, mapSize)!=0)
+    throw SAException(ERROR_CACHE_FILE_ACCESS);
+  void* map = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_File, 0);
+  if (map==MAP_FAILED)
+    throw SAException(ERROR_CACHE_FILE_ACCESS);
+  munmap(m_Map, m_MapSize);
+  m_Map = (char*) map;
+  m_MapSize = mapSize;
+  m_Records = m_Map + sizeof(CacheHeader);
+  m_Capacity = capacity;
+}
+
+char* EvalCache::getRecord(const int index) const
+{
+  return m_Records + m_RecordSize*index;
+}
+
+uint64_t EvalCache::hash(const double* inputs) const
+{
+  return fnv1a(inputs, sizeof(double)*m_NumInputs, m_Fingerprint);
+}
+
+int EvalCache::find(const uint64_t key, const double* inputs) const
+{
+  auto range = m_Index.equal_range(key);
+  for (auto it=range.first; it!=range.second; ++it)
+  {
+    char* rec = getRecord(it->second);
+    const RecordHead* head = (const RecordHead*) rec;
+    if (head->fingerprint==m_Fingerprint
+        && memcmp(rec + sizeof(RecordHead), inputs, sizeof(double)*m_NumInputs)==0)
+      return it->second;
+  }
+  return -1;
+}
+
+bool EvalCache::lookup(const double* inputs, double* outputs, int* label) const
+{
+  uint64_t key = hash(inputs);
+  std::lock_guard<std::mutex> lock(m_Lock);
+  int index = find(key, inputs);
+  if (index<0)
+  {
+    ++m_Misses;
+    return false;
+  }
+
+  char* rec = getRecord(index);
+  *label = ((const RecordHead*) rec)->label;
+  memcpy(outputs, rec + sizeof(RecordHead) + sizeof(double)*m_NumInputs,
+      sizeof(double)*m_NumOutputs);
+  ++m_Hits;
+  return true;
+}
+
+void EvalCache::store(const double* inputs, const double* outputs, const int label)
+{
+  uint64_t key = hash(inputs);
+  std::lock_guard<std::mutex> lock(m_Lock);
+  if (find(key, inputs)>=0)
+    return;
+
+  if (m_Size==m_Capacity)
+    reserve(m_Capacity>0 ? 2*m_Capacity : 1024);
+
+  /* 1. Write the record */
+  char* rec = getRecord(m_Size);
+  RecordHead* head = (RecordHead*) rec;
+  head->key = key;
+  head->fingerprint = m_Fingerprint;
+  head->label = label;
+  head->reserved = 0;
+  memcpy(rec + sizeof(RecordHead), inputs, sizeof(double)*m_NumInputs);
+  memcpy(rec + sizeof(RecordHead) + sizeof(double)*m_NumInputs, outputs,
+      sizeof(double)*m_NumOutputs);
+
+  /* 2. Then publish it, a record is only valid once counted in the header */
+  m_Index.insert(std::make_pair(key, m_Size));
+  ++m_Size;
+  if (m_Map)
+    ((CacheHeader*) m_Map)->size = m_Size;
+}
+
+void EvalCache::solveBatch(const ModelEvaluator& eval, const double* const* inputs,
+    double* const* outputs, int* labels, const int num)
+{
+  /* 1. Collect the rows which are not cached */
+  std::vector<const double*> xs;
+  std::vector<double*> ys;
+  std::vector<int> rows;
+  for (int i=0; i<num; ++i)
+  {
+    if (!lookup(inputs[i], outputs[i], &labels[i]))
+    {
+      xs.push_back(inputs[i]);
+      ys.push_back(outputs[i]);
+      rows.push_back(i);
+    }
+  }
+  if (rows.empty())
+    return;
+
+  /* 2. Solve them at once and remember the final results */
+  std::vector<int> ls(rows.size());
+  eval.solveBatch(xs.data(), ys.data(), ls.data(), rows.size());
+  for (size_t i=0; i<rows.size(); ++i)
+  {
+    labels[rows[i]] = ls[i];
+    if (ls[i]==SIM_SUCCESS || ls[i]==SIM_FAILURE)
+      store(xs[i], ys[i], ls[i]);
+  }
+}
+
+int EvalCache::getNumInputs() const
+{
+  return m_NumInputs;
+}
+
+int EvalCache::getNumOutputs() const
+{
+  return m_NumOutputs;
+}
+
+int EvalCache::size() const
+{
+  std::lock_guard<std::mutex> lock(m_Lock);
+  return m_Size;
+}
+
+long EvalCache::getNumHits() const
+{
+  return m_Hits;
+}
+
+long EvalCache::getNumMisses() const
+{
+  return m_Misses;
+}
+
+BIO_NAMESPACE_END
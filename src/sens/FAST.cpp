@@ -37,6 +37,11 @@ void FAST::doSA()
                              };
 
   int k =m_InputList->size();                   /* number of input factor */
+
+  /* the indices come from a single search curve, it has no units to
+   * resample */
+  if (m_NumBoot>0)
+    WARNING("FAST does not support bootstrap confidence intervals");
   
   if (k>50)
     throw SAException(ERROR_FAST_DIM_EXCEEDING);
@@ -0,0 +1,246 @@
+/**
+ @file GivenData.cpp
+ @brief Implementation for GivenData class
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#include "GivenData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "WorkerPool.h"
+
+BIO_NAMESPACE_BEGIN
+
+GivenData::GivenData()
+  : SABase(SA_GIVEN_DATA)
+  , N_(1000)
+  , numBins_(0)
+  , given_(false)
+{
+}
+
+void GivenData::setN(const int N)
+{
+  if (N<2)
+    throw SAException(ERROR_TOO_SMALL_SAMPLE_SIZE);
+  N_ = N;
+}
+
+void GivenData::setNumBins(const int num)
+{
+  if (num<0)
+    throw SAException(ERROR_NEGATIVE_NUM_BINS);
+  numBins_ = num;
+}
+
+void GivenData::setData(const DMatrix& inputs, const ResultMatrix& outputs)
+{
+  int n = inputs.getNumRows();
+  if (outputs.getNumRows() != n)
+    throw SAException(ERROR_GIVEN_DATA_MISMATCH);
+  if (n<2)
+    throw SAException(ERROR_TOO_SMALL_SAMPLE_SIZE);
+
+  m_InputData.reset(new DMatrix(inputs));
+  m_OutputData.reset(new ResultMatrix(n, outputs.getNumCols()));
+  for (int iRow=0; iRow<n; ++iRow)
+    m_OutputData->fillRow(iRow, outputs.getRow(iRow));
+  std::copy(outputs.getLabels(), outputs.getLabels() + n, m_OutputData->getLabels());
+  given_ = true;
+}
+
+int GivenData::getNumSens() const
+{
+  return m_NumOutputs;
+}
+
+void GivenData::doSA()
+{
+  /* 1. Simulates a sample unless one is given */
+  if (!given_)
+  {
+    m_InputData.reset(new DMatrix(N_, m_InputList->size()));
+    m_OutputData.reset(new ResultMatrix(N_, m_NumOutputs));
+    sample();
+    simulate(*m_InputData, *m_OutputData);
+  } else if (m_InputData->getNumCols() != m_InputList->size()
+      || m_OutputData->getNumCols() != m_NumOutputs)
+  {
+    throw SAException(ERROR_GIVEN_DATA_MISMATCH);
+  }
+
+  /* 2. Estimates sensitivity measures */
+  estimate();
+}
+
+void GivenData::sample()
+{
+  if (m_Sampling == MC_SAMPLING)
+  {
+    m_RNG.MC(*m_InputData);
+  } else if (m_Sampling == LHS_SAMPLING || m_Sampling == OPTIMIZED_LHS_SAMPLING)
+  {
+    sampleLHS(*m_InputData);
+  } else                                        /* sobol sequence */
+  {
+    m_RNG.setScrambling(m_Sampling == SCRAMBLED_SOBOL_SAMPLING ? 1 : 0);
+    m_RNG.sobol(*m_InputData);
+  }
+  m_RNG.convert(*m_InputData, m_InputList);
+}
+
+void GivenData::estimate()
+{
+  int n = m_InputData->getNumRows();
+  int k = m_InputList->size();
+  double** inputs = m_InputData->getData();
+  const int* labels = m_OutputData->getLabels();
+
+  int nValid = std::count(labels, labels + n, SIM_SUCCESS);
+  if (nValid < 2 || nValid < (1-m_FailureRate) * n)
+    throw SAException(ERROR_EXCEEDING_FAILURE_RATE);
+
+  /* 1. Sorts the valid samples along each factor, the factors in parallel.
+   * Ties are broken by the sample index so that the order is reproducible */
+  order_.assign(k, std::vector<int>());
+  WorkerPool pool(m_NumThreads);
+  pool.run(k, 1, [&](const int, const int begin, const int end)
+      {
+        std::vector<std::pair<double, int> > keys;
+        keys.reserve(nValid);
+        for (int iK=begin; iK<end; ++iK)
+        {
+          keys.clear();
+          for (int iRow=0; iRow<n; ++iRow)
+          {
+            if (labels[iRow] == SIM_SUCCESS)
+              keys.emplace_back(inputs[iRow][iK], iRow);
+          }
+          std::sort(keys.begin(), keys.end());
+          order_[iK].resize(nValid);
+          for (int i=0; i<nValid; ++i)
+            order_[iK][i] = keys[i].second;
+        }
+      });
+
+  /* 2. The point estimates take every sample once */
+  std::vector<int> weights(n, 1);
+  pool.run(k, 1, [&](const int, const int begin, const int end)
+      {
+        estimate(weights, begin, end, *m_Sens);
+      });
+
+  /* 3. A resample weighs the samples by their number of draws, the sorted
+   * orders are thus reused */
+  if (m_NumBoot>0)
+  {
+    bootstrap(n,
+        [this, n, k](const int* units, DMatrix& sens)
+        {
+          std::vector<int> weights(n, 0);
+          for (int i=0; i<n; ++i)
+            weights[units[i]]++;
+          estimate(weights, 0, k, sens);
+        });
+  }
+}
+
+void GivenData::estimate(const std::vector<int>& weights, const int begin,
+    const int end, DMatrix& sens) const
+{
+  int nOut = m_NumOutputs;
+  double** outputs = m_OutputData->getData();
+
+  /* 1. Total weight of the valid samples and their sum of squared weights */
+  long long W = 0;
+  long long W2 = 0;
+  for (int iRow : order_[0])
+  {
+    W += weights[iRow];
+    W2 += (long long) weights[iRow]*weights[iRow];
+  }
+  if (W<2)
+  {
+    for (int iK=begin; iK<end; ++iK)
+      std::fill(sens.getRow(iK), sens.getRow(iK) + nOut, NAN);
+    return;
+  }
+  long long M = numBins_>0 ? numBins_ : std::llround(std::sqrt((double) W));
+  M = std::max(1LL, std::min(M, W-1));
+
+  /* outputs are shifted by a sample to limit cancellation in the sums of
+   * squares */
+  const double* ref = outputs[order_[0][0]];
+
+  std::vector<double> binSums(nOut), sums(nOut), sums2(nOut), ssb(nOut);
+  for (int iK=begin; iK<end; ++iK)
+  {
+    /* 2. Walks the samples along factor iK, a sample falls in the bin of
+     * the weight preceding it */
+    std::fill(binSums.begin(), binSums.end(), 0);
+    std::fill(sums.begin(), sums.end(), 0);
+    std::fill(sums2.begin(), sums2.end(), 0);
+    std::fill(ssb.begin(), ssb.end(), 0);
+    long long cum = 0;                          /* weight of the samples walked */
+    long long bin = 0;
+    long long binW = 0;                         /* weight of the current bin */
+    long long binW2 = 0;                        /* its sum of squared weights */
+    /* the noise of a bin mean grows with the squared weights of its samples,
+     * q sums them relative to the bin weights. With unit weights q is the
+     * number of bins and the correction is the usual M-1 */
+    double q = 0;
+    auto closeBin = [&]()
+    {
+      if (binW == 0)
+        return;
+      for (int iOut=0; iOut<nOut; ++iOut)
+      {
+        ssb[iOut] += binSums[iOut]*binSums[iOut]/binW;
+        binSums[iOut] = 0;
+      }
+      q += (double) binW2/binW;
+      binW = 0;
+      binW2 = 0;
+    };
+
+    for (int iRow : order_[iK])
+    {
+      int w = weights[iRow];
+      if (w == 0)
+        continue;
+      long long b = cum*M/W;
+      if (b != bin)
+      {
+        closeBin();
+        bin = b;
+      }
+      const double* y = outputs[iRow];
+      for (int iOut=0; iOut<nOut; ++iOut)
+      {
+        double d = y[iOut] - ref[iOut];
+        binSums[iOut] += w*d;
+        sums[iOut] += w*d;
+        sums2[iOut] += w*d*d;
+      }
+      binW += w;
+      binW2 += w*w;
+      cum += w;
+    }
+    closeBin();
+
+    /* 3. Between-bin variance corrected by the within-bin variance */
+    double* row = sens.getRow(iK);
+    for (int iOut=0; iOut<nOut; ++iOut)
+    {
+      double sst = sums2[iOut] - sums[iOut]*sums[iOut]/W;
+      double between = ssb[iOut] - sums[iOut]*sums[iOut]/W;
+      double within = sst - between;
+      row[iOut] = (between - (q - (double) W2/W)*within/(W-q))/sst;
+    }
+  }
+}
+
+BIO_NAMESPACE_END
@@ -5,10 +5,60 @@
   */
 
 #include "InputDist.h"
+
+#include <algorithm>
+#include <cmath>
+
 #include "common/SaException.h"
+#include "normal.h"
 
 BIO_NAMESPACE_BEGIN
 
+namespace
+{
+  /* continued fraction of the incomplete beta function, by the modified
+   * Lentz method */
+  double betaFraction(const double a, const double b, const double x)
+  {
+    const double TINY = 1e-300;
+    double c = 1;
+    double d = 1 - (a+b)*x/(a+1);
+    d = 1/(std::fabs(d) < TINY ? TINY : d);
+    double h = d;
+    for (int m=1; m<=300; ++m)
+    {
+      /* even then odd step */
+      for (int odd=0; odd<2; ++odd)
+      {
+        double num = odd
+          ? -(a+m)*(a+b+m)*x/((a+2*m)*(a+2*m+1))
+          : m*(b-m)*x/((a+2*m-1)*(a+2*m));
+        d = 1 + num*d;
+        d = 1/(std::fabs(d) < TINY ? TINY : d);
+        c = 1 + num/c;
+        c = std::fabs(c) < TINY ? TINY : c;
+        h *= d*c;
+        if (odd && std::fabs(d*c-1) < 1e-15)
+          return h;
+      }
+    }
+    return h;
+  }
+
+  /* regularized incomplete beta function I_x(a, b) */
+  double betaCdf(const double a, const double b, const double lbeta, const double x)
+  {
+    if (x <= 0)
+      return 0;
+    if (x >= 1)
+      return 1;
+    double front = std::exp(a*std::log(x) + b*std::log1p(-x) - lbeta);
+    if (x < (a+1)/(a+b+2))
+      return front*betaFraction(a, b, x)/a;
+    return 1 - front*betaFraction(b, a, 1-x)/b;
+  }
+}
+
 InputDist::InputDist(const InputDistType_t& type /* DIST_UNKNOWN */)
   : m_Type(type)
 {
@@ -52,5 +102,202 @@ double InputNormal::getStd() const
   return std_;
 }
 
+InputTabulated::InputTabulated(const InputDistType_t& type)
+  : InputDist(type)
+{
+}
+
+const std::vector<double>& InputTabulated::getTable() const
+{
+  return m_Table;
+}
+
+double InputTabulated::quantile(const double p) const
+{
+  int last = m_Table.size()-1;
+  double x = p*last;
+  int j = std::min((int) x, last-1);
+  return m_Table[j] + (x-j)*(m_Table[j+1]-m_Table[j]);
+}
+
+void InputTabulated::checkTable() const
+{
+  for (size_t j=0; j<m_Table.size(); ++j)
+  {
+    if (!std::isfinite(m_Table[j]) || (j>0 && m_Table[j]<m_Table[j-1]))
+    {
+      throw InputException("The quantile table is not finite and non decreasing");
+    }
+  }
+}
+
+InputLogNormal::InputLogNormal(const double mu, const double sigma)
+  : InputTabulated(DIST_LOGNORMAL)
+  , mu_(mu)
+  , sigma_(sigma)
+{
+  if (sigma_ <= 0)
+  {
+    throw InputException("Standard deviation must be positive");
+  }
+  tabulate([this](const double p)
+      {
+        return std::exp(truncated_normal_ab_cdf_inv(p, mu_, sigma_,
+              mu_ - 3*sigma_, mu_ + 3*sigma_));
+      });
+}
+
+double InputLogNormal::getMu() const
+{
+  return mu_;
+}
+
+double InputLogNormal::getSigma() const
+{
+  return sigma_;
+}
+
+InputTriangular::InputTriangular(const double lower, const double mode,
+    const double upper)
+  : InputTabulated(DIST_TRIANGULAR)
+  , lower_(lower)
+  , mode_(mode)
+  , upper_(upper)
+{
+  if (lower_ >= upper_ || mode_ < lower_ || mode_ > upper_)
+  {
+    throw InputException("The mode must be within lower bound < upper bound");
+  }
+  double modeCdf = (mode_-lower_)/(upper_-lower_);
+  tabulate([this, modeCdf](const double p)
+      {
+        if (p < modeCdf)
+          return lower_ + std::sqrt(p*(upper_-lower_)*(mode_-lower_));
+        return upper_ - std::sqrt((1-p)*(upper_-lower_)*(upper_-mode_));
+      });
+}
+
+double InputTriangular::getLower() const
+{
+  return lower_;
+}
+
+double InputTriangular::getMode() const
+{
+  return mode_;
+}
+
+double InputTriangular::getUpper() const
+{
+  return upper_;
+}
+
+InputBeta::InputBeta(const double alpha, const double beta, const double lower,
+    const double upper)
+  : InputTabulated(DIST_BETA)
+  , alpha_(alpha)
+  , beta_(beta)
+{
+  if (alpha_ <= 0 || beta_ <= 0)
+  {
+    throw InputException("Beta shape parameters must be positive");
+  }
+  if (lower >= upper)
+  {
+    throw InputException("Lower bound must be smaller than upper bound");
+  }
+
+  /* inverts the incomplete beta function by Newton steps kept within a
+   * bracket, starting from the previous quantile */
+  double lbeta = std::lgamma(alpha_) + std::lgamma(beta_) - std::lgamma(alpha_+beta_);
+  double x = 0;
+  tabulate([&](const double p)
+      {
+        if (p <= 0 || p >= 1)
+          return lower + (upper-lower)*(p <= 0 ? 0 : 1);
+        double lo = x, hi = 1;
+        if (x <= 0)
+          x = std::fmin(std::pow(p*alpha_*std::exp(lbeta), 1/alpha_), 0.5);
+        for (int iter=0; iter<200; ++iter)
+        {
+          double f = betaCdf(alpha_, beta_, lbeta, x) - p;
+          if (f < 0)
+            lo = x;
+          else
+            hi = x;
+          double pdf = std::exp((alpha_-1)*std::log(x)
+              + (beta_-1)*std::log1p(-x) - lbeta);
+          double next = x - f/pdf;
+          next = next > lo && next < hi ? next : (lo+hi)/2;
+          if (f == 0 || std::fabs(next-x) <= 1e-15*x)
+            break;
+          x = next;
+        }
+        return lower + (upper-lower)*x;
+      });
+}
+
+double InputBeta::getAlpha() const
+{
+  return alpha_;
+}
+
+double InputBeta::getBeta() const
+{
+  return beta_;
+}
+
+InputPiecewiseLinear::InputPiecewiseLinear(const std::vector<double>& xs,
+    const std::vector<double>& densities)
+  : InputTabulated(DIST_PIECEWISE_LINEAR)
+{
+  int n = xs.size();
+  if (n < 2 || (int) densities.size() != n)
+  {
+    throw InputException("A piecewise linear density needs at least 2 points and one density per point");
+  }
+
+  /* 1. Cumulative masses at the boundaries */
+  std::vector<double> cdf(n, 0);
+  for (int i=0; i<n-1; ++i)
+  {
+    if (xs[i+1] <= xs[i] || densities[i] < 0)
+    {
+      throw InputException("Boundaries must increase and densities must not be negative");
+    }
+    cdf[i+1] = cdf[i] + (densities[i]+densities[i+1])/2*(xs[i+1]-xs[i]);
+  }
+  if (densities[n-1] < 0 || !(cdf[n-1] > 0))
+  {
+    throw InputException("The densities must have a positive integral");
+  }
+
+  /* 2. Solves the quadratic cumulative mass within the segment of p */
+  tabulate([&](const double p)
+      {
+        double mass = p*cdf[n-1];
+        int i = std::upper_bound(cdf.begin(), cdf.end(), mass) - cdf.begin() - 1;
+        i = std::max(0, std::min(i, n-2));
+        double width = xs[i+1]-xs[i];
+        double slope = (densities[i+1]-densities[i])/width;
+        double m = mass - cdf[i];
+        double root = std::sqrt(std::fmax(densities[i]*densities[i] + 2*slope*m, 0));
+        double t = densities[i] + root > 0 ? 2*m/(densities[i] + root) : 0;
+        return xs[i] + std::fmin(std::fmax(t, 0), width);
+      });
+}
+
+InputEmpirical::InputEmpirical(const std::vector<double>& samples)
+  : InputTabulated(DIST_EMPIRICAL)
+{
+  if (samples.size() < 2)
+  {
+    throw InputException("An empirical distribution needs at least 2 samples");
+  }
+  m_Table = samples;
+  std::sort(m_Table.begin(), m_Table.end());
+  checkTable();
+}
+
 BIO_NAMESPACE_END
 
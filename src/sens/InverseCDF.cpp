@@ -0,0 +1,122 @@
+/**
+ @file InverseCDF.cpp
+ @brief Implementation for the batch inverse-CDF transforms
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#include "InverseCDF.h"
+
+#include <cmath>
+
+#include "normal.h"
+
+BIO_NAMESPACE_BEGIN
+
+namespace
+{
+  /* coefficients of the central region of AS 241, see normal_01_cdf_inv */
+  const double A[8] = {
+    3.3871328727963666080,     1.3314166789178437745e+2,
+    1.9715909503065514427e+3,  1.3731693765509461125e+4,
+    4.5921953931549871457e+4,  6.7265770927008700853e+4,
+    3.3430575583588128105e+4,  2.5090809287301226727e+3 };
+  const double B[8] = {
+    1.0,                       4.2313330701600911252e+1,
+    6.8718700749205790830e+2,  5.3941960214247511077e+3,
+    2.1213794301586595867e+4,  3.9307895800092710610e+4,
+    2.8729085735721942674e+4,  5.2264952788528545610e+3 };
+  const double CONST1 = 0.180625;
+  const double SPLIT1 = 0.425;
+
+  /* the values processed at once, small enough to stay in L1 */
+  const int BLOCK = 256;
+}
+
+void InverseCDF::pow10(double* values, const int n)
+{
+  for (int i=0; i<n; ++i)
+    values[i] = pow(10, values[i]);
+}
+
+void InverseCDF::uniform(double* values, const int n, const double lower,
+    const double upper)
+{
+  double distance = upper-lower;
+  for (int i=0; i<n; ++i)
+    values[i] = values[i]*distance + lower;
+}
+
+void InverseCDF::logUniform(double* values, const int n, const double lower,
+    const double upper)
+{
+  double ll = log10(lower);
+  double ldist = log10(upper) - ll;
+  for (int i=0; i<n; ++i)
+    values[i] = values[i]*ldist + ll;
+  pow10(values, n);
+}
+
+void InverseCDF::tabulated(double* values, const int n, const double* table,
+    const int size)
+{
+  int last = size-1;
+  for (int i=0; i<n; ++i)
+  {
+    double x = values[i]*last;
+    int j = (int) x;
+    j = j < last ? j : last-1;
+    values[i] = table[j] + (x-j)*(table[j+1]-table[j]);
+  }
+}
+
+void InverseCDF::normal01(double* values, const int n)
+{
+  double central[BLOCK];
+  for (int begin=0; begin<n; begin+=BLOCK)
+  {
+    double* p = values + begin;
+    int m = n-begin < BLOCK ? n-begin : BLOCK;
+
+    /* 1. The central rational approximation for all, in Horner order as
+     * r8poly_value */
+    for (int i=0; i<m; ++i)
+    {
+      double q = p[i] - 0.5;
+      double r = CONST1 - q*q;
+      double num = 0, den = 0;
+      for (int j=7; j>=0; --j)
+      {
+        num = num*r + A[j];
+        den = den*r + B[j];
+      }
+      central[i] = q*num/den;
+    }
+
+    /* 2. The few values in the tails go through the scalar path */
+    for (int i=0; i<m; ++i)
+      p[i] = fabs(p[i] - 0.5) <= SPLIT1 ? central[i] : normal_01_cdf_inv(p[i]);
+  }
+}
+
+void InverseCDF::truncatedNormal(double* values, const int n,
+    const double mean, const double std, const double a, const double b)
+{
+  double alphaCdf = normal_01_cdf((a - mean)/std);
+  double betaCdf = normal_01_cdf((b - mean)/std);
+  double width = betaCdf - alphaCdf;
+
+  for (int i=0; i<n; ++i)
+    values[i] = width*values[i] + alphaCdf;
+  normal01(values, n);
+  for (int i=0; i<n; ++i)
+    values[i] = mean + std*values[i];
+}
+
+void InverseCDF::truncatedLogNormal(double* values, const int n,
+    const double mean, const double std, const double a, const double b)
+{
+  truncatedNormal(values, n, mean, std, a, b);
+  pow10(values, n);
+}
+
+BIO_NAMESPACE_END
@@ -7,6 +7,7 @@
 #include "Jansen.h"
 
 #include <memory>
+#include <vector>
 
 BIO_NAMESPACE_BEGIN
 
@@ -70,92 +71,122 @@ void Jansen::sample()
 }
 
 void Jansen::estimate()
+{
+  /* the point estimates take every step of the winding stairs once */
+  std::vector<int> units(r_+1);
+  for (int iR=0; iR<=r_; ++iR)
+    units[iR] = iR;
+  estimate(units.data(), *m_Sens, true);
+
+  if (m_NumBoot>0)
+  {
+    bootstrap(r_+1,
+        [this](const int* units, DMatrix& sens)
+        {
+          estimate(units, sens, false);
+        });
+  }
+}
+
+void Jansen::estimate(const int* units, DMatrix& sens, const bool check)
 {
   int k = m_InputData->getNumCols();            /* number of input factors */
+  int nOut = m_OutputData->getNumCols();        /* number of outputs */
   int N = k*(r_+1);
   double minCnt = (1-m_FailureRate) * r_;
   int* labels = m_OutputData->getLabels();
-
-  /* allocates a temporary vector of Di of input factors */
-  std::unique_ptr<double[]> Dvec_ptr(new double[k]);
-  double* Dvec = Dvec_ptr.get();
-
-  /* allocate a temporary vector of Dt of input factors */
-  std::unique_ptr<double[]> Dtvec_ptr(new double[k]);
-  double* Dtvec = Dtvec_ptr.get();
-
   double ** outputs = m_OutputData->getData();
 
-  for (int iOut = 0; iOut< m_OutputData->getNumCols(); ++iOut) /* for each output */
-  {
-    double D=0;                                   /* total output variance */
-    double f0 = 0;                              /* mean of outputs */
+  /* sums of each factor, outputs are the inner dimension so that a row of
+   * outputs is read once */
+  std::vector<double> f0(k*nOut, 0);            /* mean of column iK */
+  std::vector<double> colD(k*nOut, 0);          /* output variance of column iK */
+  std::vector<double> Dvec(k*nOut, 0);          /* Di of input factors */
+  std::vector<double> Dtvec(k*nOut, 0);         /* Dt of input factors */
+  std::vector<int> cnts(3*k, 0);                /* countt the numbers of valid simulation results */
 
-    for (int iK=0; iK<k; ++iK)                  /* for each input factor */
+  for (int iK=0; iK<k; ++iK)                    /* for each input factor */
+  {
+    double* f0K = &f0[iK*nOut];
+    double* colDK = &colD[iK*nOut];
+    double* DK = &Dvec[iK*nOut];
+    double* DtK = &Dtvec[iK*nOut];
+
+    /* Iterates over the resampled rows of the winding stair design matrix
+     * of outputs */
+    for (int iUnit=0; iUnit<=r_; ++iUnit)
     {
-      int cnts[3] = {0, 0, 0};                  /* countt the numbers of valid simulation results */
-      Dvec[iK] = 0;
-      Dtvec[iK] = 0;
-      double colD = 0;                             /* output variance of column iK */
-      double f0 = 0;                            /* mean of column iK */
-
-      /* Iterates from the first row to 'r' row of the winding stair design
-       * matrix of outputs */
-      for (int iR=0; iR<=r_; ++iR)
+      /* Identifies row ids of samples for variance estimation 
+       * - a sample at baseId row belongs to column iK of winding stairs design
+       *
+       * Since the total number of samples is N=(r+1)*k, nextId and prevId
+       * should never exceed N
+       **/
+      int baseId = units[iUnit]*k + iK;          
+      int prevId = baseId-1;         
+      int nextId = baseId + k-1;
+      if (labels[baseId] == SIM_SUCCESS)
       {
-        /* Identifies row ids of samples for variance estimation 
-         * - a sample at baseId row belongs to column iK of winding stairs design
-         *
-         * Since the total number of samples is N=(r+1)*k, nextId and prevId
-         * should never exceed N
-         **/
-        int baseId = iR*k + iK;          
-        int prevId = baseId-1;         
-        int nextId = baseId + k-1;
-        if (labels[baseId] == SIM_SUCCESS)
+        const double* y = outputs[baseId];
+        cnts[3*iK]++;
+        for (int iOut=0; iOut<nOut; ++iOut)
         {
-          cnts[0]++;
-          f0 += outputs[baseId][iOut];
-          colD += outputs[baseId][iOut]*outputs[baseId][iOut];
+          f0K[iOut] += y[iOut];
+          colDK[iOut] += y[iOut]*y[iOut];
+        }
 
-          if (nextId<N && labels[prevId] == SIM_SUCCESS)
+        if (nextId<N && labels[nextId] == SIM_SUCCESS)
+        {
+          cnts[3*iK+1]++;
+          for (int iOut=0; iOut<nOut; ++iOut)
           {
-            cnts[1]++;
-            double diff =  outputs[baseId][iOut] - outputs[nextId][iOut];
-            Dvec[iK] += diff*diff;
+            double diff =  y[iOut] - outputs[nextId][iOut];
+            DK[iOut] += diff*diff;
           }
+        }
 
-          if (prevId>0 && labels[nextId] == SIM_SUCCESS)
+        if (prevId>=0 && labels[prevId] == SIM_SUCCESS)
+        {
+          cnts[3*iK+2]++;
+          for (int iOut=0; iOut<nOut; ++iOut)
           {
-            cnts[2]++;
-            double diff =  outputs[baseId][iOut] - outputs[prevId][iOut];
-            Dtvec[iK] += diff*diff;
+            double diff =  y[iOut] - outputs[prevId][iOut];
+            DtK[iOut] += diff*diff;
           }
         }
       }
-      if (cnts[0] < minCnt
-          || cnts[1] < minCnt
-          || cnts[2] < minCnt
-          )
-      {
-        throw SAException(ERROR_EXCEEDING_FAILURE_RATE);
-      }
-      f0 /= cnts[0];
-      D += (colD/cnts[0]-f0*f0);
-      Dvec[iK] /= 2*cnts[1];
-      Dtvec[iK] /= 2*cnts[2];
+    }
+    if (check
+        && (cnts[3*iK] < minCnt
+          || cnts[3*iK+1] < minCnt
+          || cnts[3*iK+2] < minCnt)
+        )
+    {
+      throw SAException(ERROR_EXCEEDING_FAILURE_RATE);
+    }
+  }
+
+  for (int iOut = 0; iOut<nOut; ++iOut)         /* for each output */
+  {
+    double D=0;                                 /* total output variance */
+    for (int iK=0; iK<k; ++iK)
+    {
+      int id = iK*nOut + iOut;
+      double mean = f0[id]/cnts[3*iK];
+      D += (colD[id]/cnts[3*iK]-mean*mean);
+      Dvec[id] /= 2*cnts[3*iK+1];
+      Dtvec[id] /= 2*cnts[3*iK+2];
     }
     /* estimate D */
     D /= k;
     /* estimate sensitivity measures */
     for (int iK=0; iK<k; ++iK)
     {
-      double* sens = m_Sens->getRow(iK);
-      sens[2*iOut] = 1 - Dvec[iK]/D;
-      sens[2*iOut+1] = Dtvec[iK]/D;
+      double* row = sens.getRow(iK);
+      row[2*iOut] = 1 - Dvec[iK*nOut + iOut]/D;
+      row[2*iOut+1] = Dtvec[iK*nOut + iOut]/D;
     }
   }
 }
 
 BIO_NAMESPACE_END
-
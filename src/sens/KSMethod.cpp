@@ -56,7 +56,7 @@ void KSMethod::sample()
   int numsamples = getNumSamples();
   std::unique_ptr<double[]> valueptr(new double[numsamples]);
   double* values = valueptr.get();
-  m_RNG.LHS(*m_InputData);
+  sampleLHS(*m_InputData);
 }
 
 void KSMethod::estimate()
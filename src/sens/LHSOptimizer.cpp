@@ -0,0 +1,139 @@
+/**
+ @file LHSOptimizer.cpp
+ @brief Implementation for LHSOptimizer class
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#include "LHSOptimizer.h"
+
+#include <cmath>
+#include <limits>
+
+BIO_NAMESPACE_BEGIN
+
+namespace
+{
+  /* d2^(-p/2) by repeated squaring, several times faster than pow() */
+  double invPow(const double d2, const int p)
+  {
+    double x = 1/d2;
+    double ret = p%2 ? std::sqrt(x) : 1;
+    for (int e=p/2; e>0; e>>=1, x*=x)
+    {
+      if (e & 1)
+        ret *= x;
+    }
+    return ret;
+  }
+}
+
+LHSOptimizer::LHSOptimizer(const DMatrix& mat, const Deadline_t& deadline,
+    const int p)
+  : m_NumRows(mat.getNumRows())
+  , m_NumCols(mat.getNumCols())
+  , m_Power(p)
+  , m_Design(m_NumRows*m_NumCols)
+  , m_Sum(0)
+  , m_Complete(false)
+{
+  /* the nearest neighbours are about n^(-1/k) apart, scaling keeps d^-p
+   * within the range of doubles */
+  m_Scale = std::pow((double) m_NumRows, 1.0/m_NumCols);
+  for (int i=0; i<m_NumRows; ++i)
+  {
+    const double* row = mat.getRow(i);
+    for (int c=0; c<m_NumCols; ++c)
+      m_Design[i*m_NumCols + c] = row[c]*m_Scale;
+  }
+
+  /* a row costs O(n*k), the deadline is checked every few rows */
+  for (int i=0; i<m_NumRows; ++i)
+  {
+    if (i % 16 == 0 && std::chrono::steady_clock::now() >= deadline)
+      return;
+    m_Sum += rowSum(i, -1);
+  }
+  m_Sum /= 2;
+  m_Complete = true;
+}
+
+double LHSOptimizer::rowSum(const int i, const int skip) const
+{
+  const double* xi = &m_Design[i*m_NumCols];
+  double sum = 0;
+  for (int j=0; j<m_NumRows; ++j)
+  {
+    if (j==i || j==skip)
+      continue;
+    const double* xj = &m_Design[j*m_NumCols];
+    double d2 = 0;
+    for (int c=0; c<m_NumCols; ++c)
+      d2 += (xi[c]-xj[c]) * (xi[c]-xj[c]);
+    sum += invPow(d2, m_Power);
+  }
+  return sum;
+}
+
+double LHSOptimizer::getCriterion() const
+{
+  if (!m_Complete)
+    return std::numeric_limits<double>::infinity();
+  return std::pow(m_Sum, 1.0/m_Power);
+}
+
+void LHSOptimizer::getDesign(DMatrix& mat) const
+{
+  for (int i=0; i<m_NumRows; ++i)
+  {
+    double* row = mat.getRow(i);
+    for (int c=0; c<m_NumCols; ++c)
+      row[c] = m_Design[i*m_NumCols + c]/m_Scale;
+  }
+}
+
+int LHSOptimizer::optimize(RNGStream& rng, const int iterations,
+    const Deadline_t& deadline)
+{
+  if (m_NumRows<3 || !m_Complete)
+    return 0;
+
+  /* geometric cooling from 0.5% of the criterion down to 1e-4 of that */
+  double phi = getCriterion();
+  double temp = 0.005*phi;
+  double cooling = std::pow(1e-4, 1.0/iterations);
+
+  int it = 0;
+  for (; it<iterations; ++it, temp *= cooling)
+  {
+    if (it % 64 == 0 && std::chrono::steady_clock::now() >= deadline)
+      break;
+
+    /* 1. Proposes to exchange column c of rows i1 and i2 */
+    int c = (int) (rng.rand()*m_NumCols);
+    int i1 = (int) (rng.rand()*m_NumRows);
+    int i2 = (int) (rng.rand()*(m_NumRows-1));
+    i2 += i2>=i1;
+
+    /* 2. Only the pairs of i1 and i2 change, their own pair keeps its
+     * distance */
+    double before = rowSum(i1, i2) + rowSum(i2, i1);
+    std::swap(m_Design[i1*m_NumCols + c], m_Design[i2*m_NumCols + c]);
+    double after = rowSum(i1, i2) + rowSum(i2, i1);
+    double sum = m_Sum - before + after;
+    double next = std::pow(std::fmax(sum, 0), 1.0/m_Power);
+
+    /* 3. Metropolis acceptance */
+    double delta = next - phi;
+    if (delta <= 0 || rng.rand() < std::exp(-delta/temp))
+    {
+      m_Sum = sum;
+      phi = next;
+    } else
+    {
+      std::swap(m_Design[i1*m_NumCols + c], m_Design[i2*m_NumCols + c]);
+    }
+  }
+  return it;
+}
+
+BIO_NAMESPACE_END
@@ -7,12 +7,16 @@
 
 #include "ModelEvaluator.h"
 
+#include "common/CommonDefs.h"
+#include "ResultMatrix.h"
+
 BIO_NAMESPACE_BEGIN
 
 ModelEvaluator::ModelEvaluator(const int nInputs, const int nOutputs)
   : m_NumInputs(nInputs)
   , m_NumOutputs(nOutputs)
     , m_UserData(nullptr)
+  , m_TimeBudget(0)
 {
 
 }
@@ -27,6 +31,52 @@ void ModelEvaluator::setUserData(void* data)
   m_UserData = data;
 }
 
+void ModelEvaluator::solveBatch(const double* const* inputs,
+    double* const* outputs, int* labels, const int num) const
+{
+  for (int i=0; i<num; ++i)
+  {
+    m_Token.setBudget(m_TimeBudget);
+    int ret = m_Token.getStatus();
+    if (ret == SATOOLS_SUCCESS)
+    {
+      ret = solve(inputs[i], outputs[i]);
+      /* a failure may be caused by the token */
+      if (ret != SATOOLS_SUCCESS && m_Token.isStopped())
+        ret = m_Token.getStatus();
+    }
+
+    if (ret == SATOOLS_SUCCESS)
+    {
+      labels[i] = SIM_SUCCESS;
+    } else if (ret == ERROR_TIME_BUDGET_EXCEEDED)
+    {
+      labels[i] = SIM_TIMEOUT;
+    } else if (ret == ERROR_SIMULATION_CANCELLED)
+    {
+      labels[i] = SIM_CANCELLED;
+    } else
+    {
+      labels[i] = SIM_FAILURE;
+    }
+  }
+}
+
+void ModelEvaluator::setTimeBudget(const double seconds)
+{
+  m_TimeBudget = seconds;
+}
+
+void ModelEvaluator::setParentToken(const CancelToken* parent)
+{
+  m_Token.setParent(parent);
+}
+
+const CancelToken* ModelEvaluator::getCancelToken() const
+{
+  return &m_Token;
+}
+
 int ModelEvaluator::getNumInputs() const
 {
   return m_NumInputs;
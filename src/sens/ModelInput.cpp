@@ -5,6 +5,9 @@
   */
 
 #include "ModelInput.h"
+
+#include <algorithm>
+
 #include "common/SaException.h"
 
 BIO_NAMESPACE_BEGIN
@@ -124,6 +127,49 @@ ModelInput& ModelInput::setNormal(const double mean, const double std)
   m_Dist = new InputNormal(mean, std);
   return *this;
 }
+
+ModelInput& ModelInput::setLogNormal(const double mu, const double sigma)
+{
+  InputDist* dist = new InputLogNormal(mu, sigma);
+  delete m_Dist;
+  m_Dist = dist;
+  return *this;
+}
+
+ModelInput& ModelInput::setTriangular(const double lower, const double mode,
+    const double upper)
+{
+  InputDist* dist = new InputTriangular(lower, mode, upper);
+  delete m_Dist;
+  m_Dist = dist;
+  return *this;
+}
+
+ModelInput& ModelInput::setBeta(const double alpha, const double beta,
+    const double lower, const double upper)
+{
+  InputDist* dist = new InputBeta(alpha, beta, lower, upper);
+  delete m_Dist;
+  m_Dist = dist;
+  return *this;
+}
+
+ModelInput& ModelInput::setPiecewiseLinear(const std::vector<double>& xs,
+    const std::vector<double>& densities)
+{
+  InputDist* dist = new InputPiecewiseLinear(xs, densities);
+  delete m_Dist;
+  m_Dist = dist;
+  return *this;
+}
+
+ModelInput& ModelInput::setEmpirical(const std::vector<double>& samples)
+{
+  InputDist* dist = new InputEmpirical(samples);
+  delete m_Dist;
+  m_Dist = dist;
+  return *this;
+}
 /*  
 ModelInput& ModelInput::setDist(const InputDist& dist)
 {
@@ -143,6 +189,17 @@ ModelInput& ModelInput::setIndex(const int index)
   return *this;
 }
 
+const std::string& ModelInput::getGroup() const
+{
+  return m_Group;
+}
+
+ModelInput& ModelInput::setGroup(const std::string& group)
+{
+  m_Group = group;
+  return *this;
+}
+
 
 ModelInputList::ModelInputList()
 {
@@ -210,5 +267,30 @@ int ModelInputList::size() const
   return m_List.size();
 }
 
+std::vector<std::vector<int> > ModelInputList::getGroups() const
+{
+  std::vector<std::vector<int> > ret;
+  std::vector<std::string> names;
+  for (int i=0; i<size(); ++i)
+  {
+    const std::string& group = m_List[i]->getGroup();
+    size_t iGroup = group.empty() ? names.size()
+      : std::find(names.begin(), names.end(), group) - names.begin();
+    if (iGroup == names.size())
+    {
+      names.push_back(group);
+      ret.push_back(std::vector<int>());
+    }
+    ret[iGroup].push_back(i);
+  }
+  return ret;
+}
+
+std::string ModelInputList::getGroupName(const int index) const
+{
+  const ModelInput* first = get(getGroups()[index][0]);
+  return first->getGroup().empty() ? first->getName() : first->getGroup();
+}
+
 BIO_NAMESPACE_END
 
@@ -5,8 +5,13 @@
   */
 #include "Morris.h"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 #include "ModelInput.h"
 #include "ModelOutput.h"
+#include "WorkerPool.h"
 
 BIO_NAMESPACE_BEGIN
 
@@ -15,6 +20,7 @@ Morris::Morris()
   , perm_(nullptr)
   , r_(20)
   , p_(4)
+  , candidates_(0)
 {
 }
 
@@ -33,6 +39,13 @@ void Morris::setP(const int p)
   p_ = p;
 }
 
+void Morris::setCandidates(const int num)
+{
+  if (num<0)
+    throw SAException(ERROR_NEGATIVE_MORRIS_CANDIDATES);
+  candidates_ = num;
+}
+
 int Morris::getNumSens() const
 {
   return 3*m_NumOutputs;                /* each output has 3 sensitivity measues, muy, muystar and std */
@@ -48,15 +61,6 @@ void Morris::sample()
   int k = m_InputList->size();                 /* number of outputs */
   double delta = 0.5*p_/(p_-1);
 
- /* Allocates the base vector xstar */
-  std::unique_ptr<double[]> xstar_ptr(new double[k]);
-  double* xstar = xstar_ptr.get();             
-
-  /* Allocates a vector to hold randomized indexes in order to generate xstar
-   * randomly*/
-  std::unique_ptr<int[]> xstar_indexes_ptr(new int[k]);
-  int* xstar_indexes = xstar_indexes_ptr.get(); 
-
  /* Creates a vector that holds all feasible attibute values of xstar*/
   int num_xstar_values = (int) floor((1-delta)*(p_-1)); /* size of the vector */
   std::unique_ptr<double[]> xstar_values_ptr(new double[num_xstar_values+1]);
@@ -65,149 +69,299 @@ void Morris::sample()
   for (int i=0; i<= num_xstar_values; ++i)
     xstar_values[i] = (double)i/(p_-1);  /* x_star_values = {0, 1/(p-1), ... ,1-delta} */
 
- /* Creates a temporary row vector that later will be used for column permutation of Bstar matrix*/
-  std::unique_ptr<double[]> tmprow_ptr(new double[k]);
-  double* tmprow = tmprow_ptr.get();           
+  /* Trajectories are written in place, or to a pool when they are selected
+   * from candidates */
+  int nCandidates = candidates_ > r_ ? candidates_ : r_;
+  std::unique_ptr<DMatrix> candidates(nullptr);
+  DMatrix* x = m_InputData.get();
+  if (nCandidates > r_)
+  {
+    candidates.reset(new DMatrix(nCandidates*(k+1), k));
+    x = candidates.get();
+  }
 
   /* Allocates array of index permutation vector */
-  perm_.reset(new IMatrix(r_, k));
+  perm_.reset(new IMatrix(nCandidates, k));
 
-  /* Creates trajectories */
-  for (int iR=0; iR < r_; ++iR) 
-  {
+  /* Creates trajectories, each one from its own random stream */
+  m_RNG.nextDraw();
+  WorkerPool pool(m_RNG.getNumThreads());
+  pool.run(nCandidates, 1, [&](const int, const int begin, const int end)
+      {
+        /* Allocates the base vector xstar */
+        std::unique_ptr<double[]> xstar_ptr(new double[k]);
+        double* xstar = xstar_ptr.get();             
 
-    /* 1. Randomly generate a base vector xstar */
+        /* Allocates a vector to hold randomized indexes in order to generate xstar
+         * randomly*/
+        std::unique_ptr<int[]> xstar_indexes_ptr(new int[k]);
+        int* xstar_indexes = xstar_indexes_ptr.get(); 
 
-    m_RNG.rand(0, num_xstar_values, xstar_indexes, k); /* randomly generate indexes */
-    for (int iK=0; iK<k; ++iK)
-    {
-      xstar[iK] = xstar_values[xstar_indexes[iK]];
-    }
+        /* Creates a temporary row vector that later will be used for column permutation of Bstar matrix*/
+        std::unique_ptr<double[]> tmprow_ptr(new double[k]);
+        double* tmprow = tmprow_ptr.get();           
+
+        for (int iR=begin; iR < end; ++iR) 
+        {
+          RNGStream rng = m_RNG.getStream(iR);
 
-    /* 2. Generate sammpling matrix Bstar */
+          /* 1. Randomly generate a base vector xstar */
+
+          rng.rand(0, num_xstar_values, xstar_indexes, k); /* randomly generate indexes */
+          for (int iK=0; iK<k; ++iK)
+          {
+            xstar[iK] = xstar_values[xstar_indexes[iK]];
+          }
 
-    /* 2.1 Generate B matrix */
-    /*  Instead of allocate Bstar, lets it points to internal data of m_InputData */
-    double** Bstar = &(m_InputData->getData()[iR*(k+1)]);
-    /* Make it lower triangle matrix of value ones */
+          /* 2. Generate sammpling matrix Bstar */
+
+          /* 2.1 Generate B matrix */
+          /*  Instead of allocate Bstar, lets it points to internal data of m_InputData */
+          double** Bstar = &(x->getData()[iR*(k+1)]);
+          /* Make it lower triangle matrix of value ones */
+          for (int iRow=0; iRow<k+1; ++iRow)
+          {
+            for (int iCol=0; iCol<k; ++iCol)
+            {
+              Bstar[iRow][iCol] = (iRow > iCol) ? delta : 0.0;
+            }
+          }
+    
+          /* 2.2 Change signs of the values of about half of the colums. These colums are chosen
+           * randomly with equal probability */
+          for (int iCol = 0; iCol<k; ++iCol)          /* for each column */
+          {
+            if  (rng.rand() < 0.5)                  /* change or not change? */
+            {
+              for (int iRow=0; iRow<k+1; ++iRow)
+              {
+                if (Bstar[iRow][iCol]>0.0)              /* Bstar[iRow][iCol] = delta */
+                {
+                  Bstar[iRow][iCol] = 0.0;
+                } else                                /* Bstar[iRow][iCol] = 0.0 */
+                {
+                  Bstar[iRow][iCol] = delta;
+                }
+              }
+            }        
+          }
+
+          /* 2.3 Randomly permutate colum of B, the result is Bstar matrix 
+           * NOTE: this is might be not neccessary*/
+
+          /* create permuation indexes */
+          int* indexRow = perm_->getRow(iR);
+          for (int iCol=0; iCol<k; ++iCol)
+            indexRow[iCol] = iCol;
+          rng.shuffle(indexRow, k);            /* shuffle */
+    
+          /* permutation on every rows */
+          for (int iRow = 0; iRow <= k; ++iRow)
+          {
+            /* copy the row to temporary vector */
+            for (int iCol=0; iCol<k; ++iCol)
+            {
+              tmprow[iCol] = Bstar[iRow][iCol];
+            }
+            /* now copy it back with permuted indexes  */
+            for (int iCol=0; iCol<k; ++iCol)
+            {
+              Bstar[iRow][indexRow[iCol]] = tmprow[iCol];
+            }     
+          }
+
+          /* 2.4 Add the base vector to make samples */
+          for (int iRow=0; iRow<k+1; ++iRow)
+          {
+            for (int iCol=0; iCol<k; ++iCol)
+            {
+              Bstar[iRow][iCol] += xstar[iCol];
+            }
+          }
+        }
+      });
+  if (nCandidates == r_)
+    return;
+
+  /* Keeps the most spread candidates */
+  DMatrix dist(nCandidates, nCandidates);
+  distances(*x, dist);
+  std::vector<int> kept = select(dist);
+  std::unique_ptr<IMatrix> perm(new IMatrix(r_, k));
+  for (int iR=0; iR<r_; ++iR)
+  {
     for (int iRow=0; iRow<k+1; ++iRow)
+      m_InputData->fillRow(iR*(k+1)+iRow, x->getRow(kept[iR]*(k+1)+iRow));
+    perm->fillRow(iR, perm_->getRow(kept[iR]));
+  }
+  perm_ = std::move(perm);
+}
+
+void Morris::distances(const DMatrix& x, DMatrix& dist) const
+{
+  int k = m_InputList->size();
+  int nPoints = k+1;                            /* points of a trajectory */
+  int nTraj = dist.getNumRows();
+
+  /* 1. Transposes the trajectories, the distances from a point to all points
+   * of another trajectory are then accumulated one coordinate at a time in
+   * independent lanes */
+  std::vector<double> xt((size_t) nTraj*k*nPoints);
+  for (int iT=0; iT<nTraj; ++iT)
+  {
+    for (int iRow=0; iRow<nPoints; ++iRow)
     {
+      const double* row = x.getRow(iT*nPoints+iRow);
       for (int iCol=0; iCol<k; ++iCol)
-      {
-        Bstar[iRow][iCol] = (iRow > iCol) ? delta : 0.0;
-      }
+        xt[((size_t) iT*k+iCol)*nPoints+iRow] = row[iCol];
     }
-    
-    /* 2.2 Change signs of the values of about half of the colums. These colums are chosen
-     * randomly with equal probability */
-    for (int iCol = 0; iCol<k; ++iCol)          /* for each column */
-    {
-      if  (m_RNG.rand() < 0.5)                  /* change or not change? */
+  }
+
+  /* 2. Each row of the distances against the previous trajectories */
+  WorkerPool pool(m_NumThreads);
+  pool.run(nTraj, 1, [&](const int, const int begin, const int end)
       {
-        for (int iRow=0; iRow<k+1; ++iRow)
+        std::vector<double> d2(nPoints);
+        for (int iT=begin; iT<end; ++iT)
         {
-          if (Bstar[iRow][iCol]>0.0)              /* Bstar[iRow][iCol] = delta */
-          {
-            Bstar[iRow][iCol] = 0.0;
-          } else                                /* Bstar[iRow][iCol] = 0.0 */
+          dist.getRow(iT)[iT] = 0;
+          for (int iU=0; iU<iT; ++iU)
           {
-            Bstar[iRow][iCol] = delta;
+            double d = 0;
+            for (int iRow=0; iRow<nPoints; ++iRow)
+            {
+              const double* a = x.getRow(iT*nPoints+iRow);
+              std::fill(d2.begin(), d2.end(), 0.0);
+              for (int iCol=0; iCol<k; ++iCol)
+              {
+                const double* b = &xt[((size_t) iU*k+iCol)*nPoints];
+                double ai = a[iCol];
+                for (int j=0; j<nPoints; ++j)
+                  d2[j] += (ai-b[j])*(ai-b[j]);
+              }
+              for (int j=0; j<nPoints; ++j)
+                d += sqrt(d2[j]);
+            }
+            dist.getRow(iT)[iU] = d;
+            dist.getRow(iU)[iT] = d;
           }
         }
-      }        
-    }
+      });
+}
 
-    /* 2.3 Randomly permutate colum of B, the result is Bstar matrix 
-     * NOTE: this is might be not neccessary*/
+std::vector<int> Morris::select(const DMatrix& dist) const
+{
+  int nTraj = dist.getNumRows();
 
-    /* create permuation indexes */
-    int* indexRow = perm_->getRow(iR);
-    for (int iCol=0; iCol<k; ++iCol)
-      indexRow[iCol] = iCol;
-    m_RNG.shuffle(indexRow, k);            /* shuffle */
-    
-    /* permutation on every rows */
-    for (int iRow = 0; iRow <= k; ++iRow)
-    {
-      /* copy the row to temporary vector */
-      for (int iCol=0; iCol<k; ++iCol)
-      {
-        tmprow[iCol] = Bstar[iRow][iCol];
-      }
-      /* now copy it back with permuted indexes  */
-      for (int iCol=0; iCol<k; ++iCol)
-      {
-        Bstar[iRow][indexRow[iCol]] = tmprow[iCol];
-      }     
-    }
+  /* 1. The spread of a set is the sum of its squared distances, removing a
+   * trajectory takes away its sum to the others */
+  std::vector<double> sums(nTraj, 0);
+  for (int iT=0; iT<nTraj; ++iT)
+  {
+    const double* row = dist.getRow(iT);
+    for (int iU=0; iU<nTraj; ++iU)
+      sums[iT] += row[iU]*row[iU];
+  }
 
-    /* 2.4 Add the base vector to make samples */
-    for (int iRow=0; iRow<k+1; ++iRow)
+  /* 2. Removes the trajectory of smallest sum until r are left */
+  std::vector<char> kept(nTraj, 1);
+  for (int nLeft=nTraj; nLeft>r_; --nLeft)
+  {
+    int worst = std::find(kept.begin(), kept.end(), 1) - kept.begin();
+    for (int iT=worst+1; iT<nTraj; ++iT)
     {
-      for (int iCol=0; iCol<k; ++iCol)
-      {
-        Bstar[iRow][iCol] += xstar[iCol];
-      }
+      if (kept[iT] && sums[iT]<sums[worst])
+        worst = iT;
     }
+    kept[worst] = 0;
+    const double* row = dist.getRow(worst);
+    for (int iT=0; iT<nTraj; ++iT)
+      sums[iT] -= row[iT]*row[iT];
+  }
+
+  std::vector<int> ret;
+  for (int iT=0; iT<nTraj; ++iT)
+  {
+    if (kept[iT])
+      ret.push_back(iT);
   }
+  return ret;
 }
 
 void Morris::estimate()
+{
+  /* the point estimates take every trajectory once */
+  std::vector<int> units(r_);
+  for (int iR=0; iR<r_; ++iR)
+    units[iR] = iR;
+  estimate(units.data(), *m_Sens, true);
+
+  if (m_NumBoot>0)
+  {
+    bootstrap(r_,
+        [this](const int* units, DMatrix& sens)
+        {
+          estimate(units, sens, false);
+        });
+  }
+}
+
+void Morris::estimate(const int* units, DMatrix& sens, const bool check)
 {
   int k = m_InputList->size();
   double delta = 0.5*p_/(p_-1);
   
-  std::unique_ptr<DMatrix> stats_ptr(new DMatrix(k, 3)); /* temporary matrix to hold statistic values */
-  double** stats = stats_ptr->getData();
-  std::unique_ptr<int[]> cnts(new int[k]);      /* vector to hold the number of valid simulation results */
+  /* temporary vector to hold statistic values of each factor, outputs are
+   * the inner dimension so that a row of outputs is read once */
+  std::vector<double> stats(3*k*m_NumOutputs, 0);
+  std::vector<int> cnts(k, 0);                  /* vector to hold the number of valid simulation results */
 
   int* labels = m_OutputData->getLabels();
 
-  for (int iOut = 0; iOut<m_NumOutputs; ++iOut)
+  for (int iUnit=0; iUnit<r_; ++iUnit)
   {
-    for (int iK=0; iK<k; ++iK)
-    {
-      cnts[iK] = 0;
-      stats[iK][0] = 0;
-      stats[iK][1] = 0;
-      stats[iK][2] = 0;
-    }
-
-    for (int iR=0; iR<r_; ++iR)
+    int iR = units[iUnit];
+    int* indexRow = perm_->getRow(iR);
+    int currentRow = iR*(k+1);
+    for (int iRow=0; iRow<k; ++iRow)
     {
-      int* indexRow = perm_->getRow(iR);
-      int currentRow = iR*(k+1);
-      for (int iRow=0; iRow<k; ++iRow)
+      int curEfIndex = indexRow[iRow];
+      if (labels[currentRow] == SIM_SUCCESS
+          && labels[currentRow+1] == SIM_SUCCESS)
       {
-        int curEfIndex = indexRow[iRow];
-        if (labels[currentRow] == SIM_SUCCESS
-            && labels[currentRow+1] == SIM_SUCCESS)
+        const double* y0 = m_OutputData->getRow(currentRow);
+        const double* y1 = m_OutputData->getRow(currentRow+1);
+        double* st = &stats[3*m_NumOutputs*curEfIndex];
+        for (int iOut = 0; iOut<m_NumOutputs; ++iOut)
         {
-          double ef = m_OutputData->getRow(currentRow+1)[iOut]
-              - m_OutputData->getRow(currentRow)[iOut];
-          stats[curEfIndex][0] += ef;           /* for mean estimation*/
-          stats[curEfIndex][1] += abs(ef);      /* for absolute mean estimation */
-          stats[curEfIndex][2] += ef*ef;        /* for variance estimation*/
-          cnts[curEfIndex]++;
+          double ef = y1[iOut] - y0[iOut];
+          st[3*iOut] += ef;                     /* for mean estimation*/
+          st[3*iOut+1] += std::fabs(ef);        /* for absolute mean estimation */
+          st[3*iOut+2] += ef*ef;                /* for variance estimation*/
         }
-        currentRow++;
+        cnts[curEfIndex]++;
       }
+      currentRow++;
     }
+  }
     
-    for (int iK=0; iK<k; ++iK)
+  for (int iK=0; iK<k; ++iK)
+  {
+    if (check && cnts[iK] < (1-m_FailureRate) * r_)
+      throw SAException(ERROR_EXCEEDING_FAILURE_RATE);
+
+    double* row = sens.getRow(iK);
+    for (int iOut = 0; iOut<m_NumOutputs; ++iOut)
     {
-      if (cnts[iK] < (1-m_FailureRate) * r_)
-        throw SAException(ERROR_EXCEEDING_FAILURE_RATE);
-
-      stats[iK][0] /= cnts[iK];
-      stats[iK][1] /= cnts[iK]*delta;
-      stats[iK][2] == sqrt(stats[iK][2]/cnts[iK]-stats[iK][0]*stats[iK][0])/delta;  
-      
-      m_Sens->getRow(iK)[3*iOut] = stats[iK][0]/delta;
-      m_Sens->getRow(iK)[3*iOut+1] = stats[iK][1];
-      m_Sens->getRow(iK)[3*iOut+2] = stats[iK][2];
+      double* st = &stats[3*(m_NumOutputs*iK + iOut)];
+      st[0] /= cnts[iK];
+      st[1] /= cnts[iK]*delta;
+      st[2] = sqrt(std::max(st[2]/cnts[iK] - st[0]*st[0], 0.0))/delta;
+
+      row[3*iOut] = st[0]/delta;
+      row[3*iOut+1] = st[1];
+      row[3*iOut+2] = st[2];
     }
   }
 }
 BIO_NAMESPACE_END
-
@@ -0,0 +1,534 @@
+/**
+ @file PCE.cpp
+ @brief Implementation for PCE class
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#include "PCE.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#include "InverseCDF.h"
+#include "WorkerPool.h"
+
+BIO_NAMESPACE_BEGIN
+
+namespace
+{
+  /* QR factorization of a tall matrix whose columns are added one at a
+   * time, by modified Gram-Schmidt with reorthogonalization */
+  class IncrementalQR
+  {
+    public:
+      IncrementalQR(const int rows, const int maxCols)
+        : m_Rows(rows)
+        , m_MaxCols(maxCols)
+        , m_Cols(0)
+        , m_Q((size_t) rows*maxCols)
+        , m_R((size_t) maxCols*maxCols, 0)
+      {
+      }
+
+      int size() const
+      {
+        return m_Cols;
+      }
+
+      const double* getQ(const int iCol) const
+      {
+        return &m_Q[(size_t) iCol*m_Rows];
+      }
+
+      /* Appends a column, returns false and leaves the factorization
+       * unchanged if it depends on the previous ones */
+      bool add(const double* col)
+      {
+        if (m_Cols == m_MaxCols)
+          return false;
+        double* q = &m_Q[(size_t) m_Cols*m_Rows];
+        std::copy(col, col + m_Rows, q);
+        double norm0 = dot(q, q);
+        for (int pass=0; pass<2; ++pass)
+        {
+          for (int j=0; j<m_Cols; ++j)
+          {
+            const double* qj = getQ(j);
+            double r = dot(qj, q);
+            for (int i=0; i<m_Rows; ++i)
+              q[i] -= r*qj[i];
+            m_R[(size_t) j*m_MaxCols + m_Cols] += r;
+          }
+        }
+        double norm = dot(q, q);
+        if (!(norm > 1e-20*norm0))
+        {
+          for (int j=0; j<m_Cols; ++j)
+            m_R[(size_t) j*m_MaxCols + m_Cols] = 0;
+          return false;
+        }
+        norm = sqrt(norm);
+        for (int i=0; i<m_Rows; ++i)
+          q[i] /= norm;
+        m_R[(size_t) m_Cols*m_MaxCols + m_Cols] = norm;
+        m_Cols++;
+        return true;
+      }
+
+      /* Solves R c = qy on the first num columns */
+      void solve(const double* qy, const int num, double* c) const
+      {
+        for (int i=num-1; i>=0; --i)
+        {
+          double v = qy[i];
+          for (int j=i+1; j<num; ++j)
+            v -= m_R[(size_t) i*m_MaxCols + j]*c[j];
+          c[i] = v/m_R[(size_t) i*m_MaxCols + i];
+        }
+      }
+
+      double dot(const double* a, const double* b) const
+      {
+        double s = 0;
+        for (int i=0; i<m_Rows; ++i)
+          s += a[i]*b[i];
+        return s;
+      }
+    private:
+      int m_Rows;
+      int m_MaxCols;
+      int m_Cols;
+      std::vector<double> m_Q;                  /* orthonormal columns */
+      std::vector<double> m_R;                  /* upper triangular, row major */
+  };
+
+  /* Number of terms without improvement of the leave-one-out error after
+   * which the pursuit stops */
+  const int MAX_STALLED_TERMS = 10;
+}
+
+PCE::PCE()
+  : SABase(SA_PCE)
+  , N_(500)
+  , degree_(3)
+  , qNorm_(1)
+{
+}
+
+void PCE::setN(const int N)
+{
+  if (N<2)
+    throw SAException(ERROR_TOO_SMALL_SAMPLE_SIZE);
+  N_ = N;
+}
+
+void PCE::setDegree(const int degree)
+{
+  if (degree<1)
+    throw SAException(ERROR_NONE_POSITIVE_PCE_DEGREE);
+  degree_ = degree;
+}
+
+void PCE::setQNorm(const double q)
+{
+  if (!(q>0 && q<=1))
+    throw SAException(ERROR_INVALID_PCE_QNORM);
+  qNorm_ = q;
+}
+
+const DMatrix* PCE::getSens2() const
+{
+  return sens2_.get();
+}
+
+const std::vector<double>& PCE::getLOOError() const
+{
+  return loo_;
+}
+
+int PCE::getNumSens() const
+{
+  return 2*m_NumOutputs;                        /* first order and total indices */
+}
+
+void PCE::doSA()
+{
+  int k = m_InputList->size();
+  int nOut = m_NumOutputs;
+
+  /* 1. Draws the design on the unit hypercube, the germs are derived from
+   * it */
+  m_InputData.reset(new DMatrix(N_, k));
+  m_OutputData.reset(new ResultMatrix(N_, nOut));
+  sample();
+  DMatrix unit(*m_InputData);
+  m_RNG.convert(*m_InputData, m_InputList);
+
+  /* 2. Runs simulation to estimate outputs */
+  simulate(*m_InputData, *m_OutputData);
+
+  /* 3. The expansions are fitted on the valid samples */
+  const int* labels = m_OutputData->getLabels();
+  valid_.clear();
+  for (int iRow=0; iRow<N_; ++iRow)
+  {
+    if (labels[iRow] == SIM_SUCCESS)
+      valid_.push_back(iRow);
+  }
+  int n = valid_.size();
+  if (n < 2 || n < (1-m_FailureRate) * N_)
+    throw SAException(ERROR_EXCEEDING_FAILURE_RATE);
+
+  buildBasis();
+  evalBasis(unit);
+
+  /* 4. Selects the terms of each output, the outputs in parallel */
+  terms_.assign(nOut, std::vector<int>());
+  coefs_.assign(nOut, std::vector<double>());
+  loo_.assign(nOut, 0);
+  WorkerPool pool(m_NumThreads);
+  pool.run(nOut, 1, [&](const int, const int begin, const int end)
+      {
+        std::vector<double> y(n);
+        for (int iOut=begin; iOut<end; ++iOut)
+        {
+          for (int i=0; i<n; ++i)
+            y[i] = m_OutputData->getRow(valid_[i])[iOut];
+          select(iOut, y);
+        }
+      });
+
+  /* 5. Reads the indices from the coefficients */
+  if (k>1)
+    sens2_.reset(new DMatrix(k*(k-1)/2, nOut));
+  else
+    sens2_.reset(nullptr);
+  for (int iOut=0; iOut<nOut; ++iOut)
+    indices(iOut, coefs_[iOut], *m_Sens, sens2_.get());
+
+  /* 6. A replicate refits the selected terms on the resampled samples */
+  if (m_NumBoot>0)
+  {
+    std::vector<int> validIndex(N_, -1);
+    for (int i=0; i<n; ++i)
+      validIndex[valid_[i]] = i;
+    bootstrap(N_,
+        [this, n, nOut, &validIndex](const int* units, DMatrix& sens)
+        {
+          std::vector<int> rows;
+          for (int i=0; i<N_; ++i)
+          {
+            if (validIndex[units[i]] >= 0)
+              rows.push_back(validIndex[units[i]]);
+          }
+          int m = rows.size();
+          std::vector<double> col(m), y(m), qy, coefs;
+          for (int iOut=0; iOut<nOut; ++iOut)
+          {
+            const std::vector<int>& terms = terms_[iOut];
+            int s = terms.size();
+            IncrementalQR qr(m, s);
+            std::vector<int> kept;
+            for (int t=0; t<s; ++t)
+            {
+              const double* psi = &psi_[(size_t) terms[t]*n];
+              for (int i=0; i<m; ++i)
+                col[i] = psi[rows[i]];
+              if (qr.add(col.data()))
+                kept.push_back(t);
+            }
+            for (int i=0; i<m; ++i)
+              y[i] = m_OutputData->getRow(valid_[rows[i]])[iOut];
+            qy.resize(kept.size());
+            for (size_t j=0; j<kept.size(); ++j)
+              qy[j] = qr.dot(qr.getQ(j), y.data());
+            std::vector<double> c(kept.size());
+            qr.solve(qy.data(), kept.size(), c.data());
+
+            /* dependent terms get no share of the variance */
+            coefs.assign(s, 0);
+            for (size_t j=0; j<kept.size(); ++j)
+              coefs[kept[j]] = c[j];
+            indices(iOut, coefs, sens, nullptr);
+          }
+        });
+  }
+}
+
+void PCE::sample()
+{
+  if (m_Sampling == MC_SAMPLING)
+  {
+    m_RNG.MC(*m_InputData);
+  } else if (m_Sampling == LHS_SAMPLING || m_Sampling == OPTIMIZED_LHS_SAMPLING)
+  {
+    sampleLHS(*m_InputData);
+  } else                                        /* sobol sequence */
+  {
+    m_RNG.setScrambling(m_Sampling == SCRAMBLED_SOBOL_SAMPLING ? 1 : 0);
+    m_RNG.sobol(*m_InputData);
+  }
+}
+
+void PCE::buildBasis()
+{
+  int k = m_InputList->size();
+  double maxNorm = pow(degree_, qNorm_)*(1 + 1e-12);
+
+  /* The degrees are enumerated by total degree, then by decreasing degree
+   * of the first inputs, so that the constant comes first */
+  basis_.clear();
+  std::vector<int> alpha(k, 0);
+  std::function<void (const int, const int)> enumerate =
+    [&](const int iK, const int left)
+    {
+      if (iK == k-1)
+      {
+        alpha[iK] = left;
+        double norm = 0;
+        Term_t term;
+        for (int i=0; i<k; ++i)
+        {
+          if (alpha[i] == 0)
+            continue;
+          norm += pow(alpha[i], qNorm_);
+          term.emplace_back(i, alpha[i]);
+        }
+        if (norm <= maxNorm)
+          basis_.push_back(term);
+        return;
+      }
+      for (int d=left; d>=0; --d)
+      {
+        alpha[iK] = d;
+        enumerate(iK+1, left-d);
+      }
+    };
+  for (int total=0; total<=degree_; ++total)
+    enumerate(0, total);
+}
+
+void PCE::evalBasis(const DMatrix& unit)
+{
+  int k = m_InputList->size();
+  int n = valid_.size();
+  int P = basis_.size();
+  int nDeg = degree_ + 1;
+
+  /* 1. Maps the design to the germs, a standard normal truncated as the
+   * inputs for normal inputs, U(-1,1) for the others */
+  std::vector<bool> hermite(k);
+  DMatrix germs(n, k);
+  std::vector<double> col(n);
+  for (int iK=0; iK<k; ++iK)
+  {
+    const InputDist* dist = m_InputList->get(iK)->getDist();
+    hermite[iK] = dist && dist->getType() == DIST_NORMAL;
+    for (int i=0; i<n; ++i)
+      col[i] = unit.getRow(valid_[i])[iK];
+    if (hermite[iK])
+      InverseCDF::truncatedNormal(col.data(), n, 0, 1, -3, 3);
+    else
+      InverseCDF::uniform(col.data(), n, -1, 1);
+    germs.fillCol(iK, col.data());
+  }
+
+  /* 2. Evaluates the orthonormal polynomials of each germ by their
+   * recurrence, then their products, the samples in parallel */
+  psi_.assign((size_t) P*n, 0);
+  WorkerPool pool(m_NumThreads);
+  pool.run(n, 64, [&](const int, const int begin, const int end)
+      {
+        std::vector<double> phi(k*nDeg);
+        for (int i=begin; i<end; ++i)
+        {
+          const double* xi = germs.getRow(i);
+          for (int iK=0; iK<k; ++iK)
+          {
+            double* p = &phi[iK*nDeg];
+            double x = xi[iK];
+            p[0] = 1;
+            if (nDeg > 1)
+              p[1] = x;
+            for (int d=1; d+1<nDeg; ++d)
+            {
+              if (hermite[iK])
+                p[d+1] = x*p[d] - d*p[d-1];
+              else
+                p[d+1] = ((2*d+1)*x*p[d] - d*p[d-1])/(d+1);
+            }
+            double fact = 1;
+            for (int d=1; d<nDeg; ++d)
+            {
+              fact *= d;
+              p[d] *= hermite[iK] ? 1/sqrt(fact) : sqrt(2*d+1.0);
+            }
+          }
+          for (int j=0; j<P; ++j)
+          {
+            double v = 1;
+            for (const std::pair<int, int>& f : basis_[j])
+              v *= phi[f.first*nDeg + f.second];
+            psi_[(size_t) j*n + i] = v;
+          }
+        }
+      });
+}
+
+void PCE::select(const int iOut, const std::vector<double>& y)
+{
+  int n = valid_.size();
+  int P = basis_.size();
+  int maxTerms = std::min(P, n-1);
+
+  std::vector<double> norms(P);
+  for (int j=0; j<P; ++j)
+  {
+    const double* psi = &psi_[(size_t) j*n];
+    double s = 0;
+    for (int i=0; i<n; ++i)
+      s += psi[i]*psi[i];
+    norms[j] = sqrt(s);
+  }
+
+  double mean = 0;
+  for (int i=0; i<n; ++i)
+    mean += y[i];
+  mean /= n;
+  double var = 0;
+  for (int i=0; i<n; ++i)
+    var += (y[i]-mean)*(y[i]-mean);
+  var /= n;
+
+  /* r is the residual, h the diagonal of the hat matrix */
+  IncrementalQR qr(n, std::max(maxTerms, 1));
+  std::vector<double> r(y), h(n, 0), qy;
+  std::vector<bool> tried(P, false);
+  std::vector<int> active;
+  std::vector<double> loos;                     /* leave-one-out errors by size */
+  double bestLOO = std::numeric_limits<double>::infinity();
+  int bestSize = 0;
+  int stalled = 0;
+
+  while (qr.size() < maxTerms && stalled < MAX_STALLED_TERMS)
+  {
+    /* 1. The constant first, then the term most correlated with the
+     * residual */
+    int next = -1;
+    if (qr.size() == 0 && !tried[0])
+    {
+      next = 0;
+    } else
+    {
+      double bestCorr = -1;
+      for (int j=0; j<P; ++j)
+      {
+        if (tried[j] || norms[j] == 0)
+          continue;
+        double corr = fabs(qr.dot(&psi_[(size_t) j*n], r.data()))/norms[j];
+        if (corr > bestCorr)
+        {
+          bestCorr = corr;
+          next = j;
+        }
+      }
+    }
+    if (next < 0)
+      break;
+    tried[next] = true;
+    if (!qr.add(&psi_[(size_t) next*n]))
+      continue;
+    active.push_back(next);
+
+    /* 2. Updates the residual and the leave-one-out error */
+    const double* q = qr.getQ(qr.size()-1);
+    double b = qr.dot(q, y.data());
+    qy.push_back(b);
+    double loo = 0;
+    for (int i=0; i<n; ++i)
+    {
+      r[i] -= b*q[i];
+      h[i] += q[i]*q[i];
+      double e = h[i] < 1 - 1e-10
+        ? r[i]/(1-h[i])
+        : std::numeric_limits<double>::infinity();
+      loo += e*e;
+    }
+    loo /= n;
+    loos.push_back(loo);
+
+    if (loo < bestLOO)
+    {
+      bestLOO = loo;
+      bestSize = qr.size();
+      stalled = 0;
+    } else
+    {
+      stalled++;
+    }
+  }
+
+  /* 3. Keeps the expansion of smallest leave-one-out error. Unless the
+   * output is constant, it keeps the constant and at least one other term
+   * so that it has a variance */
+  int size = var > 0 ? std::max(bestSize, std::min(2, qr.size())) : std::min(1, qr.size());
+  terms_[iOut].assign(active.begin(), active.begin() + size);
+  coefs_[iOut].resize(size);
+  qr.solve(qy.data(), size, coefs_[iOut].data());
+  loo_[iOut] = size > 0 ? loos[size-1]/var : NAN;
+}
+
+void PCE::indices(const int iOut, const std::vector<double>& coefs,
+    DMatrix& sens, DMatrix* sens2) const
+{
+  int k = m_InputList->size();
+  const std::vector<int>& terms = terms_[iOut];
+
+  for (int iK=0; iK<k; ++iK)
+    sens.getRow(iK)[2*iOut] = sens.getRow(iK)[2*iOut+1] = 0;
+  if (sens2)
+  {
+    for (int iPair=0; iPair<sens2->getNumRows(); ++iPair)
+      sens2->getRow(iPair)[iOut] = 0;
+  }
+
+  /* the variance is the sum of the squared coefficients but the constant */
+  double D = 0;
+  for (size_t t=0; t<terms.size(); ++t)
+  {
+    const Term_t& term = basis_[terms[t]];
+    if (term.empty())
+      continue;
+    double c2 = coefs[t]*coefs[t];
+    D += c2;
+    for (const std::pair<int, int>& f : term)
+      sens.getRow(f.first)[2*iOut+1] += c2;
+    if (term.size() == 1)
+    {
+      sens.getRow(term[0].first)[2*iOut] += c2;
+    } else if (term.size() == 2 && sens2)
+    {
+      int iK = term[0].first;
+      int jK = term[1].first;
+      sens2->getRow(iK*(2*k-iK-1)/2 + jK-iK-1)[iOut] += c2;
+    }
+  }
+
+  /* an expansion without variance, of a constant output, has no indices */
+  if (!(D > 0))
+    D = NAN;
+  for (int iK=0; iK<k; ++iK)
+  {
+    sens.getRow(iK)[2*iOut] /= D;
+    sens.getRow(iK)[2*iOut+1] /= D;
+  }
+  if (sens2)
+  {
+    for (int iPair=0; iPair<sens2->getNumRows(); ++iPair)
+      sens2->getRow(iPair)[iOut] /= D;
+  }
+}
+
+BIO_NAMESPACE_END
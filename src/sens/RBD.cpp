@@ -35,6 +35,10 @@ int RBD::getNumSens() const
 
 void RBD::doSA()
 {
+  /* the indices come from a single sampling, it has no units to resample */
+  if (m_NumBoot>0)
+    WARNING("RBD does not support bootstrap confidence intervals");
+
   /* 1. Determine sampling size */
   if (N_ < 2*omega_ + 1)
     throw SAException(ERROR_RBD_SMALL_SAMPLE_SIZE);
@@ -6,64 +6,143 @@
 
 #include "RNGWrapper.h"
 
+#include "InverseCDF.h"
+#include "LHSOptimizer.h"
 #include "ModelInput.h"
-#include "sobol.hpp"
-#include "normal.h"
 #include "SAException.h"
+#include "WorkerPool.h"
 
 #include <cmath>
 #include <iostream>
+#include <limits>
+#include <sstream>
 
 BIO_NAMESPACE_BEGIN
 
-RNGWrapper::RNGWrapper()
-  : urd_(0,1)
+namespace
 {
-  /* TODO: more consideration should be taken for generating the seed number */
-  std::random_device rd;
-  rng_.seed(rd());
+  /* family and identifier of the stream of the wrapper */
+  const uint32_t MAIN_FAMILY = ~(uint32_t) 0;
+  const uint64_t MAIN_STREAM = ~(uint64_t) 0;
+
+  /* Philox4x32-10 */
+  const uint32_t PHILOX_M0 = 0xD2511F53;
+  const uint32_t PHILOX_M1 = 0xCD9E8D57;
+  const uint32_t PHILOX_W0 = 0x9E3779B9;
+  const uint32_t PHILOX_W1 = 0xBB67AE85;
+
+  void philox(const uint32_t* key, const uint32_t* counter, uint32_t* out)
+  {
+    uint32_t k0 = key[0], k1 = key[1];
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    for (int iRound=0; iRound<10; ++iRound)
+    {
+      uint64_t p0 = (uint64_t) PHILOX_M0 * c0;
+      uint64_t p1 = (uint64_t) PHILOX_M1 * c2;
+      uint32_t n0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+      uint32_t n2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+      c1 = (uint32_t) p1;
+      c3 = (uint32_t) p0;
+      c0 = n0;
+      c2 = n2;
+      k0 += PHILOX_W0;
+      k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+  }
 }
 
-void RNGWrapper::rand(const int lower, const int upper, int* values, const int num)
+RNGStream::RNGStream(std::mt19937_64* engine)
+  : m_Engine(engine)
+  , m_Key{0, 0}
+  , m_Counter{0, 0, 0, 0}
+  , m_Block{0, 0, 0, 0}
+  , m_Position(0)
 {
-  std::uniform_int_distribution<> dis(lower, upper);
-  for (int i=0; i<num; ++i)
-    values[i] = dis(rng_);
 }
 
-void RNGWrapper::rand(double* values, const int num)
+RNGStream::RNGStream(const uint64_t seed, const uint32_t family, const uint64_t id)
+  : m_Engine(nullptr)
+  , m_Key{(uint32_t) seed, (uint32_t) (seed >> 32)}
+  , m_Counter{0, family, (uint32_t) id, (uint32_t) (id >> 32)}
+  , m_Block{0, 0, 0, 0}
+  , m_Position(0)
+{
+}
+
+void RNGStream::refill()
+{
+  m_Counter[0] = (uint32_t) (m_Position / 2);
+  philox(m_Key, m_Counter, m_Block);
+}
+
+void RNGStream::setPosition(const uint64_t position)
+{
+  m_Position = position;
+  if (m_Position % 2)
+    refill();
+}
+
+RNGStream::result_type RNGStream::operator()()
+{
+  if (m_Engine)
+    return (*m_Engine)();
+
+  /* a block of 128 bits gives two numbers */
+  if (m_Position % 2 == 0)
+    refill();
+  const uint32_t* half = &m_Block[2*(m_Position++ % 2)];
+  return (uint64_t) half[0] | (uint64_t) half[1] << 32;
+}
+
+double RNGStream::rand()
+{
+  std::uniform_real_distribution<> urd(0,1);
+  return urd(*this);
+}
+
+void RNGStream::rand(double* values, const int num)
 {
+  std::uniform_real_distribution<> urd(0,1);
   for (int i=0; i<num; ++i)
-    values[i] = urd_(rng_);
+    values[i] = urd(*this);
 }
-double RNGWrapper::rand()
+
+void RNGStream::rand(const int lower, const int upper, int* values, const int num)
 {
-  return urd_(rng_);
+  std::uniform_int_distribution<> dis(lower, upper);
+  for (int i=0; i<num; ++i)
+    values[i] = dis(*this);
 }
 
-void RNGWrapper::shuffle(int* values, const int num)
+void RNGStream::shuffle(int* values, const int num)
 {
-  std::shuffle(&values[0], &values[num-1], rng_);
+  std::shuffle(&values[0], &values[num-1], *this);
 }
-void RNGWrapper::randomLHS(double* values, const int n)
+
+void RNGStream::randomLHS(double* values, const int n)
 {
+  std::uniform_real_distribution<> urd(0,1);
   double offset = 1.0/n;
   
-  values[0] = urd_(rng_)/n;
+  values[0] = urd(*this)/n;
   /* make sure the first value is non-zero */
   while (values[0] <= 0.0)
-    values[0] = urd_(rng_)/n;
+    values[0] = urd(*this)/n;
 
   double l = offset;
   for (int i=1; i<n; ++i)
   {
-    values[i] = l + urd_(rng_)/n;
+    values[i] = l + urd(*this)/n;
     l += offset;
   }
-  std::shuffle(&values[0], &values[n-1], rng_);
+  std::shuffle(&values[0], &values[n-1], *this);
 }
 
-void RNGWrapper::centerLHS(double* values, const int n)
+void RNGStream::centerLHS(double* values, const int n)
 {
   double offset = 1.0/n;
   values[0] = 0.5*offset;
@@ -72,28 +151,141 @@ void RNGWrapper::centerLHS(double* values, const int n)
   {
     values[i] = values[i-1] + offset;
   }
-  std::shuffle(&values[0], &values[n-1], rng_);
+  std::shuffle(&values[0], &values[n-1], *this);
+}
+
+RNGWrapper::RNGWrapper()
+  : urd_(0,1)
+  , seeded_(false)
+  , seed_(0)
+  , draw_(0)
+  , numThreads_(1)
+  , main_(&rng_)
+  , sobolIndex_(0)
+  , replicates_(0)
+  , scrambled_(false)
+  , scrambleSeed_(0)
+  , scrambledRow_(0)
+{
+  /* TODO: more consideration should be taken for generating the seed number */
+  std::random_device rd;
+  rng_.seed(rd());
+}
+
+void RNGWrapper::setSeed(const unsigned long long seed)
+{
+  seeded_ = true;
+  seed_ = seed;
+  draw_ = 0;
+  main_ = RNGStream(seed_, MAIN_FAMILY, MAIN_STREAM);
+}
+
+bool RNGWrapper::isSeeded() const
+{
+  return seeded_;
+}
+
+void RNGWrapper::setNumThreads(const int num)
+{
+  numThreads_ = num;
+}
+
+int RNGWrapper::getNumThreads() const
+{
+  return seeded_ ? numThreads_ : 1;
+}
+
+void RNGWrapper::nextDraw()
+{
+  ++draw_;
+}
+
+unsigned long long RNGWrapper::getDraw() const
+{
+  return draw_;
+}
+
+RNGStream RNGWrapper::getStream(const unsigned long long id)
+{
+  if (!seeded_)
+    return RNGStream(&rng_);
+  return RNGStream(seed_, (uint32_t) draw_, id);
+}
+
+std::string RNGWrapper::getState() const
+{
+  std::ostringstream os;
+  os << rng_ << ' ' << urd_ << ' ' << sobolIndex_ << ' ' << seeded_ << ' '
+    << seed_ << ' ' << draw_ << ' ' << main_.m_Position << ' ' << scrambled_
+    << ' ' << scrambleSeed_ << ' ' << scrambledRow_;
+  return os.str();
+}
+
+void RNGWrapper::setState(const std::string& state)
+{
+  std::istringstream is(state);
+  uint64_t position = 0;
+  is >> rng_ >> urd_ >> sobolIndex_ >> seeded_ >> seed_ >> draw_ >> position
+    >> scrambled_ >> scrambleSeed_ >> scrambledRow_;
+  replicas_.clear();
+  main_ = seeded_ ? RNGStream(seed_, MAIN_FAMILY, MAIN_STREAM) : RNGStream(&rng_);
+  main_.setPosition(position);
+}
+
+void RNGWrapper::rand(const int lower, const int upper, int* values, const int num)
+{
+  main_.rand(lower, upper, values, num);
+}
+
+void RNGWrapper::rand(double* values, const int num)
+{
+  main_.rand(values, num);
+}
+double RNGWrapper::rand()
+{
+  return main_.rand();
+}
+
+void RNGWrapper::shuffle(int* values, const int num)
+{
+  main_.shuffle(values, num);
+}
+void RNGWrapper::randomLHS(double* values, const int n)
+{
+  main_.randomLHS(values, n);
+}
+
+void RNGWrapper::centerLHS(double* values, const int n)
+{
+  main_.centerLHS(values, n);
 }
 
 void RNGWrapper::LHS(DMatrix& mat, const bool random /*  true */)
 {
   int nRows = mat.getNumRows();
   int nCols = mat.getNumCols();
-  std::unique_ptr<double[]> values(new double[nRows]);
 
-  for (int iCol=0; iCol<nCols; ++iCol)
-  {
-    if (random)
-    {
-      randomLHS(values.get(), nRows);
-    }
-    else
-    {
-      centerLHS(values.get(), nRows);
-    }
+  /* each column has its own stream */
+  nextDraw();
+  WorkerPool pool(getNumThreads());
+  pool.run(nCols, 1, [&](const int, const int begin, const int end)
+      {
+        std::unique_ptr<double[]> values(new double[nRows]);
+        for (int iCol=begin; iCol<end; ++iCol)
+        {
+          RNGStream stream = getStream(iCol);
+          if (random)
+          {
+            stream.randomLHS(values.get(), nRows);
+          }
+          else
+          {
+            stream.centerLHS(values.get(), nRows);
+          }
 
-    mat.fillCol(iCol, values.get());
-  }
+          mat.fillCol(iCol, values.get());
+        }
+      });
 }
 
 void RNGWrapper::LHS(DMatrix& mat, const ModelInputList* inputs, const bool random)
@@ -101,6 +293,52 @@ void RNGWrapper::LHS(DMatrix& mat, const ModelInputList* inputs, const bool rand
   LHS(mat, random);
   convert(mat, inputs);
 }
+
+void RNGWrapper::optimizedLHS(DMatrix& mat, const int iterations, const double budget)
+{
+  const int NUM_CHAINS = 4;
+  int nRows = mat.getNumRows();
+  int nCols = mat.getNumCols();
+  LHSOptimizer::Deadline_t deadline = budget>0
+    ? std::chrono::steady_clock::now()
+      + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(budget))
+    : LHSOptimizer::Deadline_t::max();
+
+  /* 1. Each chain anneals its own random Latin hypercube with its own
+   * stream. Chains starting past the deadline are skipped, the first one
+   * always runs so that there is a design */
+  nextDraw();
+  std::vector<std::unique_ptr<DMatrix> > designs(NUM_CHAINS);
+  std::vector<double> criteria(NUM_CHAINS, std::numeric_limits<double>::infinity());
+  WorkerPool pool(getNumThreads());
+  pool.run(NUM_CHAINS, 1, [&](const int, const int begin, const int end)
+      {
+        std::unique_ptr<double[]> values(new double[nRows]);
+        for (int iChain=begin; iChain<end; ++iChain)
+        {
+          if (iChain>0 && std::chrono::steady_clock::now() >= deadline)
+            continue;
+          RNGStream stream = getStream(iChain);
+          designs[iChain].reset(new DMatrix(nRows, nCols));
+          for (int iCol=0; iCol<nCols; ++iCol)
+          {
+            stream.randomLHS(values.get(), nRows);
+            designs[iChain]->fillCol(iCol, values.get());
+          }
+
+          LHSOptimizer optimizer(*designs[iChain], deadline);
+          optimizer.optimize(stream, iterations, deadline);
+          optimizer.getDesign(*designs[iChain]);
+          criteria[iChain] = optimizer.getCriterion();
+        }
+      });
+
+  /* 2. Keeps the best design, the first one on ties, so the first chain
+   * if none has completed its criterion */
+  int best = std::min_element(criteria.begin(), criteria.end()) - criteria.begin();
+  designs[best]->copy(mat);
+}
 /*  
 std::unique_ptr<DMatrix> RNGWrapper::LHS(const ModelInputList* inputs, const int n, const bool random)
 {
@@ -128,17 +366,73 @@ std::unique_ptr<DMatrix> RNGWrapper::sobol(const int rows, const int cols)
 void RNGWrapper::sobol(DMatrix& mat)
 {
   int nCols = mat.getNumCols();
-  if (nCols>=1111)
+  if (nCols>SobolEngine::MAX_DIMENSION)
   {
     throw SAException(ERROR_SOBOL_EXCEEDING);
   }
 
-  static long long int seed=7123456;
-  for (int iRow = 0; iRow < mat.getNumRows(); ++iRow)
+  if (replicates_>0)
   {
-    i8_sobol(nCols, &seed, mat.getRow(iRow));
+    scrambledSobol(mat);
+    return;
   }
 
+  /* the engine is rebuilt when the dimension changes, the index goes on */
+  if (!sobol_ || sobol_->getNumDims()!=nCols)
+    sobol_.reset(new SobolEngine(nCols));
+  if (sobol_->getIndex()!=sobolIndex_)
+    sobol_->skipTo(sobolIndex_);
+  sobol_->generate(mat.getData(), mat.getNumRows());
+  sobolIndex_ = sobol_->getIndex();
+}
+
+void RNGWrapper::setSobolIndex(const unsigned long long index)
+{
+  sobolIndex_ = index;
+  scrambled_ = false;
+  scrambledRow_ = 0;
+  replicas_.clear();
+}
+
+void RNGWrapper::setScrambling(const int replicates)
+{
+  if (replicates<0)
+    throw SAException(ERROR_NONE_POSITIVE_NUM_REPLICATES);
+  if (replicates!=replicates_)
+    replicas_.clear();
+  replicates_ = replicates;
+}
+
+void RNGWrapper::scrambledSobol(DMatrix& mat)
+{
+  int nCols = mat.getNumCols();
+
+  /* 1. One seed drawn per analysis, the replicates derive theirs from it */
+  if (!scrambled_)
+  {
+    scrambleSeed_ = main_();
+    scrambled_ = true;
+  }
+  if (replicas_.empty() || replicas_[0]->getNumDims()!=nCols)
+  {
+    replicas_.clear();
+    for (int r=0; r<replicates_; ++r)
+    {
+      replicas_.emplace_back(new SobolEngine(nCols));
+      replicas_.back()->setScrambling(scrambleSeed_ + r);
+    }
+  }
+
+  /* 2. The rows deal the points of the replicates in turn */
+  double** rows = mat.getData();
+  for (int iRow=0; iRow<mat.getNumRows(); ++iRow, ++scrambledRow_)
+  {
+    SobolEngine& engine = *replicas_[scrambledRow_ % replicates_];
+    uint64_t index = scrambledRow_ / replicates_;
+    if (engine.getIndex()!=index)
+      engine.skipTo(index);
+    engine.next(rows[iRow]);
+  }
 }
 
 /*  
@@ -156,12 +450,19 @@ std::unique_ptr<DMatrix> RNGWrapper::sobol(const ModelInputList* inputs, const i
 void RNGWrapper::MC(DMatrix& mat)
 {
   int nRows = mat.getNumRows();
-  std::unique_ptr<double[]> col(new double[nRows]);
-  for (int iCol=0; iCol<mat.getNumCols(); ++iCol)
-  {
-    this->rand(col.get(), nRows);
-    mat.fillCol(iCol, col.get());
-  }
+
+  /* each column has its own stream */
+  nextDraw();
+  WorkerPool pool(getNumThreads());
+  pool.run(mat.getNumCols(), 1, [&](const int, const int begin, const int end)
+      {
+        std::unique_ptr<double[]> col(new double[nRows]);
+        for (int iCol=begin; iCol<end; ++iCol)
+        {
+          getStream(iCol).rand(col.get(), nRows);
+          mat.fillCol(iCol, col.get());
+        }
+      });
 }
 
 void RNGWrapper::MC(DMatrix& mat, const ModelInputList* inputs)
@@ -169,65 +470,92 @@ void RNGWrapper::MC(DMatrix& mat, const ModelInputList* inputs)
   MC(mat);
   convert(mat, inputs);
 }
-void RNGWrapper::convert(DMatrix& mat, const ModelInputList* inputs)
+
+void RNGWrapper::MC(DMatrix& mat, const unsigned long long draw,
+    const unsigned long long firstRow)
 {
-  for (int iCol=0; iCol<inputs->size(); ++iCol)
-  {
-    const ModelInput* ip = inputs->get(iCol);
-    const InputDist* dist = ip->getDist();
-    if (dist)
-    {
-      if (dist->getType() == DIST_UNIFORM)
+  if (!seeded_)
+    throw SAException(ERROR_UNSEEDED_RANDOM_ACCESS);
+  int nRows = mat.getNumRows();
+
+  /* a column draws one number per row from its stream */
+  WorkerPool pool(getNumThreads());
+  pool.run(mat.getNumCols(), 1, [&](const int, const int begin, const int end)
       {
-        double lower = ((const InputUniform*) dist)->getLower();
-        double upper = ((const InputUniform*) dist)->getUpper();
-        if (ip->isLog())
-        {
-          double ll = log10(lower);
-          double ldist = log10(upper) - ll;
-          mat.colEval(iCol,[&ll, &ldist](double value)
-              {
-                return pow(10, value*ldist+ll);
-              });
-          //mat.u2logU(iCol, lower, upper);
-        } else
+        std::unique_ptr<double[]> col(new double[nRows]);
+        for (int iCol=begin; iCol<end; ++iCol)
         {
-          double distance = upper-lower;
-          //mat.u2U(iCol, lower, upper);
-          mat.colEval(iCol,[&lower, &distance](double value)
-              {
-                return value*distance + lower;
-                });
+          RNGStream stream(seed_, (uint32_t) draw, iCol);
+          stream.setPosition(firstRow);
+          stream.rand(col.get(), nRows);
+          mat.fillCol(iCol, col.get());
         }
+      });
+}
+void RNGWrapper::convert(DMatrix& mat, const ModelInputList* inputs)
+{
+  const int BLOCK = 4096;                       /* rows transformed at once */
+  int nRows = mat.getNumRows();
+  int nBlocks = (nRows + BLOCK - 1)/BLOCK;
+  double** rows = mat.getData();
 
-      } else if (dist->getType() == DIST_NORMAL)
+  /* 1. Threads take blocks of rows, so that they never write to the same
+   * rows. The transforms do not draw numbers, any number of threads gives
+   * the same result */
+  WorkerPool pool(numThreads_);
+  pool.run(nBlocks, 1, [&](const int, const int begin, const int end)
       {
-        double mean = ((const InputNormal*) dist)->getMean();
-        double std = ((const InputNormal*) dist)->getStd();
-        double a = mean - 3*std;
-        double b = mean + 3*std;
-        if (!ip->isLog())
-        {
-          mat.colEval(iCol,[&mean, &std, &a, &b](double value)
-              {
-                return truncated_normal_ab_cdf_inv(value, mean, std, a, b);
-              });
-          //mat.u2logN(iCol, mean, std);
-        } else
+        double col[BLOCK];
+        for (int iBlock=begin; iBlock<end; ++iBlock)
         {
-          mat.colEval(iCol,[&mean, &std, &a, &b](double value)
-              {
-                return pow(10, truncated_normal_ab_cdf_inv(value, mean, std, a,
-                      b));
-              });
-          //mat.u2N(iCol, mean, std);
+          double** block = rows + iBlock*BLOCK;
+          int n = std::min(BLOCK, nRows - iBlock*BLOCK);
+          for (int iCol=0; iCol<inputs->size(); ++iCol)
+          {
+            const ModelInput* ip = inputs->get(iCol);
+            const InputDist* dist = ip->getDist();
+            if (!dist)
+              continue;
+
+            /* 2. Gathers a column of the block, transforms it, scatters it
+             * back */
+            for (int i=0; i<n; ++i)
+              col[i] = block[i][iCol];
+            if (dist->getType() == DIST_UNIFORM)
+            {
+              double lower = ((const InputUniform*) dist)->getLower();
+              double upper = ((const InputUniform*) dist)->getUpper();
+              if (ip->isLog())
+                InverseCDF::logUniform(col, n, lower, upper);
+              else
+                InverseCDF::uniform(col, n, lower, upper);
+            } else if (dist->getType() == DIST_NORMAL)
+            {
+              double mean = ((const InputNormal*) dist)->getMean();
+              double std = ((const InputNormal*) dist)->getStd();
+              double a = mean - 3*std;
+              double b = mean + 3*std;
+              if (!ip->isLog())
+                InverseCDF::truncatedNormal(col, n, mean, std, a, b);
+              else
+                InverseCDF::truncatedLogNormal(col, n, mean, std, a, b);
+            } else if (dist->isTabulated())
+            {
+              const std::vector<double>& table = ((const InputTabulated*) dist)->getTable();
+              InverseCDF::tabulated(col, n, table.data(), table.size());
+              if (ip->isLog())
+                InverseCDF::pow10(col, n);
+            } else
+            {
+              continue;
+            }
+            for (int i=0; i<n; ++i)
+              block[i][iCol] = col[i];
+          }
         }
-      }
-    }
-  }
+      });
 }
 
-
 std::unique_ptr<DMatrix> RNGWrapper::convertCopy(const DMatrix& mat, const ModelInputList* inputs)
 {
   std::unique_ptr<DMatrix> ret(new DMatrix(mat));
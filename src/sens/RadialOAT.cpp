@@ -0,0 +1,172 @@
+/**
+ @file RadialOAT.cpp
+ @brief Implementation for RadialOAT class
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#include "RadialOAT.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+BIO_NAMESPACE_BEGIN
+
+RadialOAT::RadialOAT()
+  : SASimple(SA_RADIAL)
+  , r_(50)
+  , pilot_(nullptr)
+{
+}
+
+void RadialOAT::setR(const int r)
+{
+  if (r<2)
+    throw SAException(ERROR_TOO_SMALL_SAMPLE_SIZE);
+  r_ = r;
+}
+
+int RadialOAT::getNumSens() const
+{
+  return 4*m_NumOutputs;                        /* mu, mu*, sigma and total index */
+}
+
+int RadialOAT::getNumSamples() const
+{
+  return r_*(m_InputList->size() + 1);
+}
+
+void RadialOAT::sample()
+{
+  int k = m_InputList->size();
+
+  /* 1. Base points in the first k columns, auxiliary points in the last k */
+  pilot_.reset(new DMatrix(r_, 2*k));
+  if (m_Sampling == MC_SAMPLING)
+  {
+    m_RNG.MC(*pilot_);
+  } else if (m_Sampling == LHS_SAMPLING || m_Sampling == OPTIMIZED_LHS_SAMPLING)
+  {
+    sampleLHS(*pilot_);
+  } else                                        /* sobol sequence */
+  {
+    m_RNG.setScrambling(m_Sampling == SCRAMBLED_SOBOL_SAMPLING ? 1 : 0);
+    m_RNG.sobol(*pilot_);
+  }
+
+  /* 2. Each base point is followed by its neighbours, neighbour iK takes
+   * factor iK from the auxiliary point */
+  for (int iR=0; iR<r_; ++iR)
+  {
+    const double* p = pilot_->getRow(iR);
+    double** rows = &(m_InputData->getData()[iR*(k+1)]);
+    for (int iRow=0; iRow<=k; ++iRow)
+    {
+      for (int iCol=0; iCol<k; ++iCol)
+        rows[iRow][iCol] = p[iCol];
+      if (iRow>0)
+        rows[iRow][iRow-1] = p[k+iRow-1];
+    }
+  }
+
+  /* 3. Converts the samples to their target distributions */
+  m_RNG.convert(*m_InputData, m_InputList);
+}
+
+void RadialOAT::estimate()
+{
+  /* the point estimates take every base point once */
+  std::vector<int> units(r_);
+  for (int iR=0; iR<r_; ++iR)
+    units[iR] = iR;
+  estimate(units.data(), *m_Sens, true);
+
+  if (m_NumBoot>0)
+  {
+    bootstrap(r_,
+        [this](const int* units, DMatrix& sens)
+        {
+          estimate(units, sens, false);
+        });
+  }
+}
+
+void RadialOAT::estimate(const int* units, DMatrix& sens, const bool check)
+{
+  int k = m_InputList->size();
+  int nOut = m_NumOutputs;
+  int* labels = m_OutputData->getLabels();
+  double** outputs = m_OutputData->getData();
+
+  /* sums of the effects, their absolute values and squares, then of the
+   * squared steps of the outputs. Outputs are the inner dimension so that a
+   * row of outputs is read once */
+  std::vector<double> stats(4*k*nOut, 0);
+  std::vector<int> cnts(k, 0);                  /* number of valid effects */
+  std::vector<double> sums(nOut, 0), sums2(nOut, 0);
+  int nValid = 0;                               /* number of valid samples */
+
+  for (int iUnit=0; iUnit<r_; ++iUnit)
+  {
+    int iR = units[iUnit];
+    int baseRow = iR*(k+1);
+
+    /* 1. Every sample contributes to the output variance */
+    for (int iRow=baseRow; iRow<=baseRow+k; ++iRow)
+    {
+      if (labels[iRow] != SIM_SUCCESS)
+        continue;
+      nValid++;
+      for (int iOut=0; iOut<nOut; ++iOut)
+      {
+        sums[iOut] += outputs[iRow][iOut];
+        sums2[iOut] += outputs[iRow][iOut]*outputs[iRow][iOut];
+      }
+    }
+
+    /* 2. The effects are taken from the base point */
+    if (labels[baseRow] != SIM_SUCCESS)
+      continue;
+    const double* p = pilot_->getRow(iR);
+    const double* y0 = outputs[baseRow];
+    for (int iK=0; iK<k; ++iK)
+    {
+      double step = p[k+iK] - p[iK];
+      if (labels[baseRow+1+iK] != SIM_SUCCESS || step == 0)
+        continue;
+      const double* y1 = outputs[baseRow+1+iK];
+      double* st = &stats[4*nOut*iK];
+      for (int iOut=0; iOut<nOut; ++iOut)
+      {
+        double diff = y1[iOut] - y0[iOut];
+        double ef = diff/step;
+        st[4*iOut] += ef;
+        st[4*iOut+1] += fabs(ef);
+        st[4*iOut+2] += ef*ef;
+        st[4*iOut+3] += diff*diff;
+      }
+      cnts[iK]++;
+    }
+  }
+
+  for (int iK=0; iK<k; ++iK)
+  {
+    if (check && cnts[iK] < (1-m_FailureRate) * r_)
+      throw SAException(ERROR_EXCEEDING_FAILURE_RATE);
+
+    double* row = sens.getRow(iK);
+    for (int iOut=0; iOut<nOut; ++iOut)
+    {
+      const double* st = &stats[4*(nOut*iK + iOut)];
+      double mean = sums[iOut]/nValid;
+      double D = sums2[iOut]/nValid - mean*mean;
+      double mu = st[0]/cnts[iK];
+      row[4*iOut] = mu;
+      row[4*iOut+1] = st[1]/cnts[iK];
+      row[4*iOut+2] = sqrt(std::max(st[2]/cnts[iK] - mu*mu, 0.0));
+      row[4*iOut+3] = st[3]/(2*cnts[iK])/D;
+    }
+  }
+}
+
+BIO_NAMESPACE_END
@@ -6,20 +6,62 @@
 
 #include "SABase.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
 
 #include "common/CommonDefs.h"
+#include "WorkerPool.h"
 
 BIO_NAMESPACE_BEGIN
 
+namespace
+{
+  /* Makespan of dispatching chunks in order, each one to the first free
+   * worker */
+  double listMakespan(const std::vector<double>& chunkCosts, const int nWorkers)
+  {
+    std::priority_queue<double, std::vector<double>, std::greater<double> > finish;
+    for (int i=0; i<nWorkers; ++i)
+      finish.push(0);
+    double makespan = 0;
+    for (double cost : chunkCosts)
+    {
+      double t = finish.top() + cost;
+      finish.pop();
+      finish.push(t);
+      makespan = std::max(makespan, t);
+    }
+    return makespan;
+  }
+}
+
 SABase::SABase(const SAMethod_t method)
   : m_Method(method)
   , m_Sampling(LHS_SAMPLING)
   , m_SobolSkip(1000)
+  , m_Seeded(false)
+  , m_Seed(0)
   , m_FailureRate(0.05)
+  , m_NumThreads(1)
+  , m_ChunkSize(1)
+  , m_TimeBudget(0)
+  , m_LHSIterations(10000)
+  , m_LHSBudget(0)
+  , m_Wave(0)
+  , m_NumBoot(0)
+  , m_Schedule(SCHEDULE_FIFO)
+  , m_ScheduleStats()
   , m_InputList(nullptr)
   , m_NumOutputs(1)
   , m_Sens(nullptr)
+  , m_Level(0.95)
 {
 }
 
@@ -36,6 +78,12 @@ void SABase::setSobolSkip(const unsigned int skip)
   m_SobolSkip = skip;
 }
 
+void SABase::setSeed(const unsigned long long seed)
+{
+  m_Seeded = true;
+  m_Seed = seed;
+}
+
 void SABase::setFailureRate(const double rate)
 {
   if (rate<0 || rate >0.2)
@@ -62,12 +110,109 @@ void SABase::setEval(std::function< std::shared_ptr<ModelEvaluator> (void*)> eva
   m_Eval = eval;
 }
 
+void SABase::setNumThreads(const int num)
+{
+  if (num<0)
+    throw SAException(ERROR_NEGATIVE_NUM_THREADS);
+  m_NumThreads = num;
+}
+
+void SABase::setChunkSize(const int size)
+{
+  if (size<=0)
+    throw SAException(ERROR_NONE_POSITIVE_CHUNK_SIZE);
+  m_ChunkSize = size;
+}
+
+void SABase::setSchedule(const Schedule_t schedule)
+{
+  m_Schedule = schedule;
+}
+
+void SABase::setCostHint(std::function<double (const double* inputs)> hint)
+{
+  m_CostHint = hint;
+}
+
+const ScheduleStats_t& SABase::getScheduleStats() const
+{
+  return m_ScheduleStats;
+}
+
+void SABase::setTimeBudget(const double seconds)
+{
+  if (seconds<0)
+    throw SAException(ERROR_NEGATIVE_TIME_BUDGET);
+  m_TimeBudget = seconds;
+}
+
+void SABase::setLHSOptimization(const int iterations, const double seconds)
+{
+  if (iterations<0 || seconds<0)
+    throw SAException(ERROR_NEGATIVE_LHS_OPTIMIZATION);
+  m_LHSIterations = iterations;
+  m_LHSBudget = seconds;
+}
+
+void SABase::cancel()
+{
+  m_Cancel.cancel();
+}
+
+void SABase::setCache(std::shared_ptr<EvalCache> cache)
+{
+  m_Cache = cache;
+}
+
+void SABase::setCheckpoint(const std::string& path)
+{
+  m_CheckpointPath = path;
+}
+
+void SABase::setBootstrap(const int num, const double level)
+{
+  if (num<0)
+    throw SAException(ERROR_NEGATIVE_NUM_BOOTSTRAP);
+  if (level<=0 || level>=1)
+    throw SAException(ERROR_INVALID_CONFIDENCE_LEVEL);
+  m_NumBoot = num;
+  m_Level = level;
+}
+
 const DMatrix* SABase::getSens() const
 {
   return m_Sens.get();
 }
 
+const DMatrix* SABase::getSensCI() const
+{
+  return m_SensCI.get();
+}
+
+const DMatrix* SABase::getInputData() const
+{
+  return m_InputData.get();
+}
+
+const ResultMatrix* SABase::getOutputData() const
+{
+  return m_OutputData.get();
+}
+
+void SABase::sampleLHS(DMatrix& mat)
+{
+  if (m_Sampling == OPTIMIZED_LHS_SAMPLING)
+    m_RNG.optimizedLHS(mat, m_LHSIterations, m_LHSBudget);
+  else
+    m_RNG.LHS(mat);
+}
+
 void SABase::simulate(const DMatrix& inputs, ResultMatrix& outputs)
+{
+  simulate(MatrixRows(inputs), outputs);
+}
+
+void SABase::simulate(const DesignRows& inputs, ResultMatrix& outputs)
 {
   INFO("ready for simulation... ");
 
@@ -75,33 +220,265 @@ void SABase::simulate(const DMatrix& inputs, ResultMatrix& outputs)
   {
     throw SAException(ERROR_NO_MODEL_EVALUATOR);
   }
+  if (m_Cache && (m_Cache->getNumInputs()!=inputs.getNumCols()
+        || m_Cache->getNumOutputs()!=outputs.getNumCols()))
+  {
+    throw SAException(ERROR_CACHE_SIZE_MISMATCH);
+  }
+
+  double** ydata = outputs.getData();
+  int* labels = outputs.getLabels();
+
+  /* Rows completed before a restart are restored */
+  int wave = m_Wave++;
+  std::vector<char> done;
+  if (m_Checkpoint)
+    m_Checkpoint->beginWave(wave, inputs, outputs, done);
+
+  /* The pending rows in the order they are dispatched */
+  std::vector<int> order;
+  for (int iRow=0; iRow<inputs.getNumRows(); ++iRow)
+  {
+    if (done.empty() || !done[iRow])
+      order.push_back(iRow);
+  }
+  int nPending = order.size();
+  if (nPending == 0)
+    return;
+  if (m_Schedule == SCHEDULE_LONGEST_FIRST)
+    schedule(inputs, order);
 
- // #pragma omp parallel
+  WorkerPool pool(m_NumThreads);
+  pool.setInterleaved(m_Schedule == SCHEDULE_LONGEST_FIRST);
+
+  /* Each busy worker owns a private evaluator */
+  int nChunks = (nPending + m_ChunkSize - 1) / m_ChunkSize;
+  int nWorkers = pool.getNumThreads() < nChunks ? pool.getNumThreads() : nChunks;
+  std::vector<std::shared_ptr<ModelEvaluator> > solvers;
+  for (int i=0; i<nWorkers; ++i)
   {
-    std::shared_ptr<ModelEvaluator> solver = m_Eval(this);
-    int* labels = outputs.getLabels();
+    solvers.push_back(m_Eval(this));
+    solvers.back()->setTimeBudget(m_TimeBudget);
+    solvers.back()->setParentToken(&m_Cancel);
+  }
 
-   // #pragma omp parallel for  
-    for (int i=0; i < inputs.getNumRows(); ++i)
-    {
+  /* Row pointers in dispatch order, the outputs are written in place. The
+   * inputs of a batch are read when it is evaluated */
+  int nCols = inputs.getNumCols();
+  std::vector<const double*> xs(nPending);
+  std::vector<double*> ys(nPending);
+  std::vector<int> ls(nPending);
+  std::vector<double> costs(nPending, 0);
+  for (int i=0; i<nPending; ++i)
+    ys[i] = ydata[order[i]];
 
-      if ( solver->solve(inputs.getRow(i), outputs.getRow(i)) 
-          == SATOOLS_SUCCESS)
+  /* Each chunk is evaluated as one batch, cached samples are skipped. The
+   * cost model needs the cost of every sample, they are then evaluated one
+   * by one */
+  int batch = m_Schedule == SCHEDULE_LONGEST_FIRST && !m_CostHint ? 1 : m_ChunkSize;
+  auto start = std::chrono::steady_clock::now();
+  pool.run(nPending, m_ChunkSize,
+      [&](const int worker, const int begin, const int end)
       {
-        labels[i] = SIM_SUCCESS;
-      } else 
+        std::vector<double> buf((size_t) batch*nCols);
+        for (int first=begin; first<end; first+=batch)
+        {
+          int last = std::min(first+batch, end);
+          for (int i=first; i<last; ++i)
+            xs[i] = inputs.getRow(order[i], &buf[(size_t) (i-first)*nCols]);
+          auto t0 = std::chrono::steady_clock::now();
+          if (m_Cache)
+            m_Cache->solveBatch(*solvers[worker], &xs[first], &ys[first],
+                &ls[first], last-first);
+          else
+            solvers[worker]->solveBatch(&xs[first], &ys[first],
+                &ls[first], last-first);
+          double cost = std::chrono::duration<double>(
+              std::chrono::steady_clock::now() - t0).count() / (last-first);
+          for (int i=first; i<last; ++i)
+          {
+            labels[order[i]] = ls[i];
+            costs[i] = cost;
+          }
+        }
+
+        /* records the runs of consecutive rows */
+        if (m_Checkpoint)
+        {
+          int first = begin;
+          while (first<end)
+          {
+            int last = first+1;
+            while (last<end && order[last] == order[last-1]+1)
+              ++last;
+            m_Checkpoint->saveRows(wave, order[first], last-first,
+                &ydata[order[first]], &labels[order[first]]);
+            first = last;
+          }
+        }
+      });
+  double makespan = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+  /* Learns the costs and replays them in both orders */
+  std::vector<double> rowCosts(inputs.getNumRows(), 0);
+  std::vector<double> buf(nCols);
+  for (int i=0; i<nPending; ++i)
+  {
+    rowCosts[order[i]] = costs[i];
+    if (!m_CostHint)
+      m_CostModel.add(inputs.getRow(order[i], buf.data()), nCols, costs[i]);
+  }
+  std::vector<int> fifo(order);
+  std::sort(fifo.begin(), fifo.end());
+  std::vector<double> fifoChunks(nChunks, 0), scheduledChunks(nChunks, 0);
+  for (int i=0; i<nPending; ++i)
+  {
+    fifoChunks[i/m_ChunkSize] += rowCosts[fifo[i]];
+    scheduledChunks[i/m_ChunkSize] += costs[i];
+  }
+  double fifoMakespan = listMakespan(fifoChunks, pool.getNumThreads());
+  double scheduledMakespan = listMakespan(scheduledChunks, pool.getNumThreads());
+  m_ScheduleStats.makespan += makespan;
+  m_ScheduleStats.fifoMakespan += fifoMakespan;
+  m_ScheduleStats.scheduledMakespan += scheduledMakespan;
+  VINFO("simulated %d samples in %gs, predicted makespan %gs in FIFO order "
+      "and %gs in the order used", nPending, makespan, fifoMakespan,
+      scheduledMakespan);
+
+  if (m_Cancel.isStopped())
+    throw SAException(ERROR_ANALYSIS_CANCELLED);
+}
+
+void SABase::schedule(const DesignRows& inputs, std::vector<int>& order) const
+{
+  if (!m_CostHint && m_CostModel.empty())
+    return;
+
+  std::vector<double> costs(inputs.getNumRows(), 0);
+  std::vector<double> buf(inputs.getNumCols());
+  for (int iRow : order)
+  {
+    const double* row = inputs.getRow(iRow, buf.data());
+    costs[iRow] = m_CostHint ? m_CostHint(row) : m_CostModel.predict(row);
+  }
+
+  /* stable so that samples of equal cost keep their order */
+  std::stable_sort(order.begin(), order.end(),
+      [&costs](const int a, const int b) { return costs[a] > costs[b]; });
+}
+
+void SABase::bootstrap(const int num, Statistic_t statistic)
+{
+  int nRows = m_Sens->getNumRows();
+  int nCols = m_Sens->getNumCols();
+  size_t nCells = (size_t) nRows*nCols;
+
+  /* 1. Draws a seed per replicate, the resamples thus do not depend on the
+   * number of threads */
+  std::vector<int> seeds(m_NumBoot);
+  m_RNG.rand(0, INT_MAX, seeds.data(), m_NumBoot);
+
+  /* 2. Estimates the indices of the replicates in parallel, each worker
+   * owns its index vector and index matrix */
+  WorkerPool pool(m_NumThreads);
+  int nWorkers = pool.getNumThreads();
+  std::vector<std::vector<int> > units(nWorkers, std::vector<int>(num));
+  std::vector<std::unique_ptr<DMatrix> > sens(nWorkers);
+  for (int i=0; i<nWorkers; ++i)
+    sens[i].reset(new DMatrix(nRows, nCols));
+  std::vector<double> replicates(m_NumBoot*nCells);
+
+  pool.run(m_NumBoot, 1,
+      [&](const int worker, const int begin, const int end)
+      {
+        for (int iBoot=begin; iBoot<end; ++iBoot)
+        {
+          std::mt19937_64 rng(seeds[iBoot]);
+          std::uniform_int_distribution<int> dis(0, num-1);
+          for (int i=0; i<num; ++i)
+            units[worker][i] = dis(rng);
+          statistic(units[worker].data(), *sens[worker]);
+
+          double* rep = &replicates[iBoot*nCells];
+          for (int iRow=0; iRow<nRows; ++iRow)
+            std::copy(sens[worker]->getRow(iRow), sens[worker]->getRow(iRow) + nCols,
+                rep + (size_t) iRow*nCols);
+        }
+      });
+
+  /* 3. Takes the percentiles of each index, ignoring undefined replicates */
+  m_SensCI.reset(new DMatrix(nRows, 2*nCols));
+  double alpha = 1-m_Level;
+  std::vector<double> values;
+  for (int iRow=0; iRow<nRows; ++iRow)
+  {
+    double* ci = m_SensCI->getRow(iRow);
+    for (int iCol=0; iCol<nCols; ++iCol)
+    {
+      values.clear();
+      for (int iBoot=0; iBoot<m_NumBoot; ++iBoot)
+      {
+        double v = replicates[iBoot*nCells + (size_t) iRow*nCols + iCol];
+        if (std::isfinite(v))
+          values.push_back(v);
+      }
+      if (values.empty())
       {
-        labels[i] = SIM_FAILURE;
+        ci[2*iCol] = ci[2*iCol+1] = NAN;
+        continue;
       }
+      std::sort(values.begin(), values.end());
+      int n = values.size();
+      ci[2*iCol] = values[(int) std::floor(alpha/2*(n-1))];
+      ci[2*iCol+1] = values[(int) std::ceil((1-alpha/2)*(n-1))];
     }
   }
+}
 
+int SABase::getNumFactors() const
+{
+  return m_InputList->size();
 }
 
 void SABase::analyze()
 {
-  m_Sens.reset(new DMatrix(m_InputList->size(), getNumSens()));
+  run(false);
+}
+
+void SABase::resume(const std::string& path)
+{
+  m_CheckpointPath = path;
+  run(true);
+}
+
+void SABase::run(const bool resume)
+{
+  m_Cancel.reset();
+  m_Wave = 0;
+  m_CostModel.clear();
+  m_ScheduleStats = ScheduleStats_t();
+  m_RNG.setSobolIndex(m_SobolSkip);
+  m_RNG.setNumThreads(m_NumThreads);
+  if (m_Seeded)
+    m_RNG.setSeed(m_Seed);
+
+  /* A resumed analysis replays the random numbers of the stopped one */
+  m_Checkpoint.reset(nullptr);
+  if (!m_CheckpointPath.empty())
+  {
+    m_Checkpoint.reset(new Checkpoint(m_CheckpointPath, m_InputList->size(),
+          m_NumOutputs, m_Method, resume));
+    if (m_Checkpoint->getState().empty())
+      m_Checkpoint->saveState(m_RNG.getState());
+    else
+      m_RNG.setState(m_Checkpoint->getState());
+  }
+
+  m_Sens.reset(new DMatrix(getNumFactors(), getNumSens()));
+  m_SensCI.reset(nullptr);
   doSA();
+  m_Checkpoint.reset(nullptr);
 }
 
 BIO_NAMESPACE_END
@@ -31,7 +31,7 @@ static const char* SAExceptionMessages[] =
   "the number of model evaluation failures has exceeded the limit",
 
   /* ERROR_SOBOL_EXCEEDING */
-  "the dimension exceeds the maximum value (1111) for sobol sequence generator",
+  "the dimension exceeds the maximum value (3667) for sobol sequence generator",
   
    /* ERROR_FAST_DIM_EXCEEDING */
   "this implementation of FAST only supports less than 50 number of input \
@@ -65,7 +65,76 @@ static const char* SAExceptionMessages[] =
   "the grid level must be greater then 1",
 
   /* ERROR_MORRIS_TOO_SMALL_R */
-  "the number of trajectories must be greater than 10"
+  "the number of trajectories must be greater than 10",
+
+  /* ERROR_NEGATIVE_NUM_THREADS */
+  "the number of threads must not be negative",
+
+  /* ERROR_NONE_POSITIVE_CHUNK_SIZE */
+  "expects a positive chunk size",
+
+  /* ERROR_NEGATIVE_PIPELINE_DEPTH */
+  "the pipeline depth must not be negative",
+
+  /* ERROR_NEGATIVE_TIME_BUDGET */
+  "the time budget must not be negative",
+
+  /* ERROR_ANALYSIS_CANCELLED */
+  "the analysis has been cancelled",
+
+  /* ERROR_CACHE_FILE_ACCESS */
+  "cannot open, grow or map the evaluation cache file",
+
+  /* ERROR_CACHE_FILE_MISMATCH */
+  "the evaluation cache file is corrupted or holds results of a model with other dimensions",
+
+  /* ERROR_CACHE_SIZE_MISMATCH */
+  "the evaluation cache does not match the number of inputs or outputs",
+
+  /* ERROR_CHECKPOINT_FILE_ACCESS */
+  "cannot open, grow or map the checkpoint file",
+
+  /* ERROR_CHECKPOINT_MISMATCH */
+  "the checkpoint file does not belong to this analysis",
+
+  /* ERROR_NEGATIVE_TOLERANCE */
+  "the tolerance must not be negative",
+
+  /* ERROR_NEGATIVE_NUM_BOOTSTRAP */
+  "the number of bootstrap replicates must not be negative",
+
+  /* ERROR_INVALID_CONFIDENCE_LEVEL */
+  "the confidence level must be in (0,1)",
+
+  /* ERROR_SOBOL_EXHAUSTED */
+  "the sobol sequence generator has no more points (2^32)",
+
+  /* ERROR_NONE_POSITIVE_NUM_REPLICATES */
+  "the number of replicates must be positive",
+
+  /* ERROR_NEGATIVE_LHS_OPTIMIZATION */
+  "the LHS optimization iterations and time budget must not be negative",
+
+  /* ERROR_NEGATIVE_STREAM_BLOCK */
+  "the number of rows of a streamed block must not be negative",
+
+  /* ERROR_UNSEEDED_RANDOM_ACCESS */
+  "random numbers can only be drawn by index with a seed",
+
+  /* ERROR_NEGATIVE_MORRIS_CANDIDATES */
+  "the number of candidate trajectories must not be negative",
+
+  /* ERROR_NEGATIVE_NUM_BINS */
+  "the number of bins must not be negative",
+
+  /* ERROR_GIVEN_DATA_MISMATCH */
+  "the given data do not match the model inputs and outputs",
+
+  /* ERROR_NONE_POSITIVE_PCE_DEGREE */
+  "the degree of the polynomial chaos expansion must be positive",
+
+  /* ERROR_INVALID_PCE_QNORM */
+  "the q-norm of the polynomial chaos basis must be in (0,1]"
 
 };
 
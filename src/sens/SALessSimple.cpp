@@ -6,12 +6,23 @@
 
 #include "SALessSimple.h"
 
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "BoundedQueue.h"
+
 BIO_NAMESPACE_BEGIN
 
 SALessSimple::SALessSimple(const SAMethod_t method)
   : SABase(method)
   , m_SaveInput(false)
   , m_SaveOutput(false)
+  , m_SingleWave(false)
+  , m_PipelineDepth(0)
+  , m_StreamBlock(0)
 { 
 }
 
@@ -24,4 +35,139 @@ void SALessSimple::setSaveOutput(const bool save)
   m_SaveOutput = save;
 }
 
+void SALessSimple::setSingleWave(const bool single)
+{
+  m_SingleWave = single;
+}
+
+void SALessSimple::setPipelineDepth(const int depth)
+{
+  if (depth<0)
+    throw SAException(ERROR_NEGATIVE_PIPELINE_DEPTH);
+  m_PipelineDepth = depth;
+}
+
+void SALessSimple::setStreamBlock(const int rows)
+{
+  if (rows<0)
+    throw SAException(ERROR_NEGATIVE_STREAM_BLOCK);
+  m_StreamBlock = rows;
+}
+
+int SALessSimple::getStreamBlock() const
+{
+  if (m_SaveInput || m_SaveOutput || m_SingleWave)
+    return 0;
+  return m_StreamBlock;
+}
+
+int SALessSimple::getNumSlots() const
+{
+  return m_PipelineDepth > 0 ? m_PipelineDepth + 2 : 1;
+}
+
+void SALessSimple::pipeline(const int num, Stage_t produce, Stage_t evaluate, Stage_t consume)
+{
+  /* Runs the stages one after another if pipelining is off */
+  if (m_PipelineDepth == 0)
+  {
+    for (int iPiece=0; iPiece<num; ++iPiece)
+    {
+      produce(iPiece, 0);
+      evaluate(iPiece, 0);
+      consume(iPiece, 0);
+    }
+    return;
+  }
+
+  typedef std::pair<int, int> Piece_t;          /* (piece, slot) */
+  int nSlots = getNumSlots();
+  BoundedQueue<int> freeSlots(nSlots);
+  BoundedQueue<Piece_t> produced(nSlots);
+  BoundedQueue<Piece_t> evaluated(nSlots);
+
+  for (int iSlot=0; iSlot<nSlots; ++iSlot)
+    freeSlots.push(iSlot);
+
+  std::atomic<bool> failed(false);
+  std::exception_ptr error(nullptr);
+  std::mutex errorLock;
+
+  /* Keeps the first exception then wakes up all stages */
+  auto fail = [&]()
+  {
+    {
+      std::lock_guard<std::mutex> guard(errorLock);
+      if (!failed)
+      {
+        error = std::current_exception();
+        failed = true;
+      }
+    }
+    freeSlots.close();
+    produced.close();
+    evaluated.close();
+  };
+
+  /* 1. Generation stage */
+  std::thread producer([&]()
+      {
+        try
+        {
+          int slot = 0;
+          for (int iPiece=0; iPiece<num && !failed; ++iPiece)
+          {
+            if (!freeSlots.pop(slot))
+              break;
+            produce(iPiece, slot);
+            if (!produced.push(Piece_t(iPiece, slot)))
+              break;
+          }
+          produced.close();
+        } catch (...)
+        {
+          fail();
+        }
+      });
+
+  /* 2. Estimation stage */
+  std::thread consumer([&]()
+      {
+        try
+        {
+          Piece_t piece;
+          while (!failed && evaluated.pop(piece))
+          {
+            consume(piece.first, piece.second);
+            freeSlots.push(piece.second);
+          }
+        } catch (...)
+        {
+          fail();
+        }
+      });
+
+  /* 3. Evaluation stage, on the calling thread */
+  try
+  {
+    Piece_t piece;
+    while (!failed && produced.pop(piece))
+    {
+      evaluate(piece.first, piece.second);
+      if (!evaluated.push(piece))
+        break;
+    }
+    evaluated.close();
+  } catch (...)
+  {
+    fail();
+  }
+
+  producer.join();
+  consumer.join();
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
 BIO_NAMESPACE_END
@@ -0,0 +1,246 @@
+/**
+ @file SobolEngine.cpp
+ @brief Implementation for SobolEngine class
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#include "SobolEngine.h"
+
+#include "SAException.h"
+
+BIO_NAMESPACE_BEGIN
+
+/* in SobolDirections.cpp */
+extern const unsigned short SOBOL_MINIT[];
+
+namespace
+{
+  const int NUM_BITS = 32;
+  const double SCALE = 1.0/4294967296.0;        /* 2^-32 */
+
+  /* degree of a polynomial over GF(2) */
+  int degree(uint32_t poly)
+  {
+    int d = -1;
+    while (poly)
+    {
+      poly >>= 1;
+      ++d;
+    }
+    return d;
+  }
+
+  /* a*b mod poly, a and b of lower degree than poly */
+  uint32_t mulmod(uint32_t a, uint32_t b, const uint32_t poly, const int deg)
+  {
+    uint32_t ret = 0;
+    while (b)
+    {
+      if (b & 1)
+        ret ^= a;
+      b >>= 1;
+      a <<= 1;
+      if (a >> deg)
+        a ^= poly;
+    }
+    return ret;
+  }
+
+  /* x^e mod poly */
+  uint32_t powmod(uint64_t e, const uint32_t poly, const int deg)
+  {
+    uint32_t ret = 1, base = 2;
+    while (e)
+    {
+      if (e & 1)
+        ret = mulmod(ret, base, poly, deg);
+      base = mulmod(base, base, poly, deg);
+      e >>= 1;
+    }
+    return ret;
+  }
+
+  /* A polynomial of degree d is primitive if x has order 2^d-1 modulo it */
+  bool isPrimitive(const uint32_t poly, const int deg)
+  {
+    /* 1. x^(2^d) = x holds for the irreducible ones */
+    uint32_t x = 2;
+    for (int i=0; i<deg; ++i)
+      x = mulmod(x, x, poly, deg);
+    if (deg>1 && x!=2)
+      return false;
+
+    /* 2. then x^((2^d-1)/q) != 1 for every prime factor q of 2^d-1 */
+    uint64_t order = (1ULL << deg) - 1, rest = order;
+    for (uint64_t q=3; q*q<=rest; q+=2)
+    {
+      if (rest % q)
+        continue;
+      if (powmod(order/q, poly, deg) == 1)
+        return false;
+      while (rest % q == 0)
+        rest /= q;
+    }
+    return rest == 1 || rest == order || powmod(order/rest, poly, deg) != 1;
+  }
+
+  /* splitmix64, the seeds of the scrambling */
+  uint64_t mix(uint64_t x)
+  {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+  }
+
+  uint32_t reverseBits(uint32_t x)
+  {
+    x = ((x >> 1) & 0x55555555U) | ((x & 0x55555555U) << 1);
+    x = ((x >> 2) & 0x33333333U) | ((x & 0x33333333U) << 2);
+    x = ((x >> 4) & 0x0F0F0F0FU) | ((x & 0x0F0F0F0FU) << 4);
+    x = ((x >> 8) & 0x00FF00FFU) | ((x & 0x00FF00FFU) << 8);
+    return (x >> 16) | (x << 16);
+  }
+
+  /* nested uniform scrambling: on the reversed digits, each bit is flipped
+   * depending on the lower ones only (the higher digits of the point) */
+  uint32_t scramble(uint32_t x, const uint32_t seed)
+  {
+    x = reverseBits(x);
+    x ^= x * 0x3d20adeaU;
+    x += seed;
+    x *= (seed >> 16) | 1;
+    x ^= x * 0x05526c56U;
+    x ^= x * 0x53a22864U;
+    return reverseBits(x);
+  }
+
+  /* index of the lowest set bit, n>0 */
+  int lowestBit(uint64_t n)
+  {
+    int ret = 0;
+    while (!(n & 1))
+    {
+      n >>= 1;
+      ++ret;
+    }
+    return ret;
+  }
+}
+
+SobolEngine::SobolEngine(const int dims)
+  : m_NumDims(dims)
+  , m_Index(0)
+  , m_Directions(NUM_BITS*dims)
+  , m_Point(dims, 0)
+{
+  if (dims<=0)
+    throw SAException(ERROR_NONE_POSITIVE_INPUT_SIZE);
+  if (dims>MAX_DIMENSION)
+    throw SAException(ERROR_SOBOL_EXCEEDING);
+
+  /* 1. Dimension 0 is the van der Corput sequence */
+  for (int k=0; k<NUM_BITS; ++k)
+    m_Directions[k*dims] = 1U << (NUM_BITS-1-k);
+
+  /* 2. The others take the primitive polynomials in increasing order */
+  const unsigned short* minit = SOBOL_MINIT;
+  uint32_t poly = 2;
+  std::vector<uint32_t> m(NUM_BITS);
+  for (int d=1; d<dims; ++d)
+  {
+    do
+      ++poly;
+    while (!(poly & 1) || !isPrimitive(poly, degree(poly)));
+    int s = degree(poly);
+
+    /* initial numbers, odd and m_k < 2^k */
+    for (int k=0; k<s; ++k)
+      m[k] = *minit++;
+
+    /* 3. V_k = m_k 2^(32-k) and the recurrence of Bratley and Fox */
+    uint32_t* v = &m_Directions[d];
+    for (int k=0; k<s && k<NUM_BITS; ++k)
+      v[k*dims] = m[k] << (NUM_BITS-1-k);
+    for (int k=s; k<NUM_BITS; ++k)
+    {
+      uint32_t vk = v[(k-s)*dims] ^ (v[(k-s)*dims] >> s);
+      for (int j=1; j<s; ++j)
+      {
+        if ((poly >> (s-j)) & 1)
+          vk ^= v[(k-j)*dims];
+      }
+      v[k*dims] = vk;
+    }
+  }
+}
+
+int SobolEngine::getNumDims() const
+{
+  return m_NumDims;
+}
+
+uint64_t SobolEngine::getIndex() const
+{
+  return m_Index;
+}
+
+void SobolEngine::skipTo(const uint64_t index)
+{
+  if (index >> NUM_BITS)
+    throw SAException(ERROR_SOBOL_EXHAUSTED);
+
+  /* point i combines the direction numbers of the bits of gray(i) */
+  uint64_t gray = index ^ (index >> 1);
+  std::fill(m_Point.begin(), m_Point.end(), 0);
+  for (int k=0; gray; ++k, gray >>= 1)
+  {
+    if (!(gray & 1))
+      continue;
+    const uint32_t* v = &m_Directions[k*m_NumDims];
+    for (int d=0; d<m_NumDims; ++d)
+      m_Point[d] ^= v[d];
+  }
+  m_Index = index;
+}
+
+void SobolEngine::next(double* point)
+{
+  generate(&point, 1);
+}
+
+void SobolEngine::generate(double* const* points, const int num)
+{
+  if (m_Index + num > (1ULL << NUM_BITS) - 1)
+    throw SAException(ERROR_SOBOL_EXHAUSTED);
+
+  /* Gray code: point i+1 differs from point i in the direction numbers of
+   * the lowest set bit of i+1 */
+  uint32_t* x = m_Point.data();
+  for (int i=0; i<num; ++i)
+  {
+    double* point = points[i];
+    if (m_Seeds.empty())
+    {
+      for (int d=0; d<m_NumDims; ++d)
+        point[d] = x[d]*SCALE;
+    } else
+    {
+      for (int d=0; d<m_NumDims; ++d)
+        point[d] = (scramble(x[d], m_Seeds[d]) + 0.5)*SCALE;
+    }
+
+    const uint32_t* v = &m_Directions[lowestBit(++m_Index)*m_NumDims];
+    for (int d=0; d<m_NumDims; ++d)
+      x[d] ^= v[d];
+  }
+}
+
+void SobolEngine::setScrambling(const uint64_t seed)
+{
+  m_Seeds.resize(m_NumDims);
+  for (int d=0; d<m_NumDims; ++d)
+    m_Seeds[d] = (uint32_t) mix(seed ^ mix(d));
+}
+
+BIO_NAMESPACE_END
@@ -6,7 +6,10 @@
 
 #include "SobolSaltelli.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <vector>
 
 BIO_NAMESPACE_BEGIN
 
@@ -14,6 +17,14 @@ SobolSaltelli::SobolSaltelli()
   : SALessSimple(SA_SOBOL2002)
   , N_(500)
   , estimator_(SOBOL2010)
+  , tolerance_(0)
+  , maxN_(0)
+  , usedN_(0)
+  , firstRow_(0)
+  , mcDraw_(0)
+  , replicates_(1)
+  , secondOrder_(false)
+  , grouped_(false)
 {
   m_Sampling = SOBOL_SAMPLING;
 }
@@ -32,6 +43,72 @@ void SobolSaltelli::setEstimator(const SobolEstimator_t type)
 {
   estimator_ = type;
 }
+void SobolSaltelli::setAdaptive(const double tolerance, const int maxN)
+{
+  if (tolerance<0)
+  {
+    throw SAException(ERROR_NEGATIVE_TOLERANCE);
+  }
+  if (tolerance>0 && maxN<=5)
+  {
+    throw SAException(ERROR_TOO_SMALL_SAMPLE_SIZE);
+  }
+
+  tolerance_ = tolerance;
+  maxN_ = maxN;
+}
+
+int SobolSaltelli::getNumSamples() const
+{
+  return usedN_;
+}
+
+void SobolSaltelli::setReplicates(const int r)
+{
+  if (r<=0)
+  {
+    throw SAException(ERROR_NONE_POSITIVE_NUM_REPLICATES);
+  }
+
+  replicates_ = r;
+}
+
+const DMatrix* SobolSaltelli::getSensStdErr() const
+{
+  return stdErr_.get();
+}
+
+void SobolSaltelli::setSecondOrder(const bool enable)
+{
+  secondOrder_ = enable;
+}
+
+const DMatrix* SobolSaltelli::getSens2() const
+{
+  return sens2_.get();
+}
+
+int SobolSaltelli::getNumMatrices() const
+{
+  int k=getNumFactors();
+  return secondOrder_ ? 2*k+2 : k+2;
+}
+
+void SobolSaltelli::setGrouped(const bool grouped)
+{
+  grouped_ = grouped;
+}
+
+int SobolSaltelli::getNumFactors() const
+{
+  return grouped_ ? m_InputList->getGroups().size() : m_InputList->size();
+}
+
+int SobolSaltelli::getNumReplicates() const
+{
+  return m_Sampling == SCRAMBLED_SOBOL_SAMPLING && replicates_>1 ? replicates_ : 0;
+}
+
 int SobolSaltelli::getNumSens() const
 {
   return 2*m_NumOutputs;
@@ -39,142 +116,501 @@ int SobolSaltelli::getNumSens() const
 
 void SobolSaltelli::doSA()
 {
-  int k=m_InputList->size();                    /* number of factors */
-  double minCnt = (1-m_FailureRate) * N_;
+  int k=getNumFactors();                        /* number of factors or groups */
+  Sums_t zero = {};
+  sums_.assign(k*m_NumOutputs, zero);
+  repSums_.assign(getNumReplicates()*k*m_NumOutputs, zero);
+  stdErr_.reset(getNumReplicates()>0
+      ? new DMatrix(m_Sens->getNumRows(), m_Sens->getNumCols()) : nullptr);
+  terms_.assign(m_NumBoot>0 ? k*m_NumOutputs : 0, std::vector<double>());
+  masks_.assign(m_NumBoot>0 ? k : 0, std::vector<char>());
+  int nPairs = secondOrder_ ? k*(k-1)/2 : 0;
+  pairSums_.assign(nPairs*m_NumOutputs, 0);
+  pairCnts_.assign(nPairs, 0);
+  sens2_.reset(nPairs>0 ? new DMatrix(nPairs, m_NumOutputs) : nullptr);
 
+  /* the inputs of each factor, a group of inputs is one factor */
+  if (grouped_)
+  {
+    factorCols_ = m_InputList->getGroups();
+  } else
+  {
+    factorCols_.clear();
+    for (int iK=0; iK < k; ++iK)
+      factorCols_.push_back(std::vector<int>(1, iK));
+  }
+
+  /* designs and outputs of the blocks if saved */
+  std::vector<std::unique_ptr<DMatrix> > xs;
+  std::vector<std::unique_ptr<ResultMatrix> > ys;
+
+  /* 1. Simulates blocks of the design, doubling the number of samples
+   * until the indices are accurate enough */
+  int n = N_;
+  usedN_ = 0;
+  while (true)
+  {
+    std::unique_ptr<DMatrix> x(nullptr);
+    std::unique_ptr<ResultMatrix> y(nullptr);
+    simulateBlock(n, x, y);
+    usedN_ += n;
+    if (m_SaveInput)
+      xs.push_back(std::move(x));
+    if (m_SaveOutput)
+      ys.push_back(std::move(y));
+
+    double width = estimate(usedN_);
+    if (stdErr_)
+      width = 1.96*estimateStdErr();
+    if (tolerance_<=0 || width<=tolerance_ || usedN_>=maxN_)
+      break;
+    VINFO("half width of the confidence intervals %g with %d samples, "
+        "extending the design", width, usedN_);
+    n = usedN_ < maxN_-usedN_ ? usedN_ : maxN_-usedN_;
+  }
+
+  /* 2. Bootstraps the samples of all blocks */
+  if (m_NumBoot>0)
+  {
+    bootstrap(usedN_,
+        [this](const int* units, DMatrix& sens)
+        {
+          resample(units, sens);
+        });
+  }
+
+  /* 3. Retains input/output data if needs */
+  if (m_SaveInput && xs.size()==1)
+  {
+    m_InputData = std::move(xs[0]);
+  } else if (m_SaveInput)
+  {
+    m_InputData.reset(new DMatrix(getNumMatrices()*usedN_, m_InputList->size()));
+    int iRow = 0;
+    for (auto& block : xs)
+      for (int i=0; i<block->getNumRows(); ++i)
+        m_InputData->fillRow(iRow++, block->getRow(i));
+  }
+
+  if (m_SaveOutput && ys.size()==1)
+  {
+    m_OutputData = std::move(ys[0]);
+  } else if (m_SaveOutput)
+  {
+    m_OutputData.reset(new ResultMatrix(getNumMatrices()*usedN_, m_NumOutputs));
+    int* labels = m_OutputData->getLabels();
+    int iRow = 0;
+    for (auto& block : ys)
+    {
+      for (int i=0; i<block->getNumRows(); ++i)
+      {
+        labels[iRow] = block->getLabels()[i];
+        m_OutputData->fillRow(iRow++, block->getRow(i));
+      }
+    }
+  }
+}
+
+void SobolSaltelli::simulateBlock(const int N, std::unique_ptr<DMatrix>& x,
+    std::unique_ptr<ResultMatrix>& y)
+{
+  /* 1. Seeded MC samples are drawn by index from a family of streams for a
+   * and the next one for b */
+  bool seededMC = m_Sampling == MC_SAMPLING && m_RNG.isSeeded();
+  if (seededMC)
+  {
+    m_RNG.nextDraw();
+    mcDraw_ = m_RNG.getDraw();
+    m_RNG.nextDraw();
+  }
+
+  /* 2. Designs addressable by sample index are generated in blocks of
+   * samples, Latin hypercubes need all of their samples at once */
+  int block = getStreamBlock();
+  bool byIndex = seededMC || m_Sampling == SOBOL_SAMPLING
+    || m_Sampling == SCRAMBLED_SOBOL_SAMPLING;
+  if (block<=0 || !byIndex)
+    block = N;
+  for (int begin=0; begin<N; begin+=block)
+  {
+    firstRow_ = usedN_ + begin;
+    simulateRows(std::min(block, N-begin), begin, x, y);
+  }
+}
+
+void SobolSaltelli::simulateRows(const int N, const int begin,
+    std::unique_ptr<DMatrix>& x, std::unique_ptr<ResultMatrix>& y)
+{
+  int k=m_InputList->size();                    /* number of inputs */
   /* a, b are pilot matrices, c has their column mixing following the sampling
    * design */
-  std::unique_ptr<DMatrix> a(nullptr), b(nullptr), c(nullptr);
-  std::unique_ptr<ResultMatrix> ya(nullptr), yb(nullptr), yc(nullptr);
+  std::unique_ptr<DMatrix> a(nullptr), b(nullptr);
+  std::unique_ptr<ResultMatrix> ya(nullptr), yb(nullptr);
 
-  /* 1. Allocates input/output data if needs */
-  if (m_SaveInput)
+  /* 1. Allocates input/output data if needs, the whole design [a; b; c_1;
+   * ...; c_k] followed by [d_1; ...; d_k] for second order indices, and its
+   * outputs are needed to save data or to evaluate in a single wave */
+  int nPieces = getNumMatrices()-2;             /* the c_i then the d_i */
+  if (m_SaveInput || m_SingleWave)
   {
-    m_InputData.reset(new DMatrix((k+2)*N_, k));
-    a = std::move(m_InputData->subMatrix(0, N_));
-    b = std::move(m_InputData->subMatrix(N_, N_));
+    x.reset(new DMatrix((2+nPieces)*N, k));
+    a = std::move(x->subMatrix(0, N));
+    b = std::move(x->subMatrix(N, N));
   } else
   {
-    a.reset(new DMatrix(N_, k));
-    b.reset(new DMatrix(N_, k));
-    c.reset(new DMatrix(N_, k));
+    a.reset(new DMatrix(N, k));
+    b.reset(new DMatrix(N, k));
   }
 
-  if (m_SaveOutput)
+  if (m_SaveOutput || m_SingleWave)
   {
-    m_OutputData.reset(new ResultMatrix((k+2)*N_, m_NumOutputs));
-    ya = std::move(m_OutputData->subMatrix(0, N_));
-    yb = std::move(m_OutputData->subMatrix(N_, N_));
+    y.reset(new ResultMatrix((2+nPieces)*N, m_NumOutputs));
+    ya = std::move(y->subMatrix(0, N));
+    yb = std::move(y->subMatrix(N, N));
   } else
   {
-    ya.reset(new ResultMatrix(N_, m_NumOutputs));
-    yb.reset(new ResultMatrix(N_, m_NumOutputs));
-    yc.reset(new ResultMatrix(N_, m_NumOutputs));
+    ya.reset(new ResultMatrix(N, m_NumOutputs));
+    yb.reset(new ResultMatrix(N, m_NumOutputs));
   }
 
   /* 2. Fill a and b with random samples */
-  if (m_Sampling == MC_SAMPLING)
+  if (m_Sampling == MC_SAMPLING && m_RNG.isSeeded())
+  {
+    m_RNG.MC(*a, mcDraw_, begin);
+    m_RNG.MC(*b, mcDraw_+1, begin);
+    m_RNG.convert(*a, m_InputList);
+    m_RNG.convert(*b, m_InputList);
+  } else if (m_Sampling == MC_SAMPLING)
   {
     m_RNG.MC(*a, m_InputList);
     m_RNG.MC(*b, m_InputList);
-  } else if (m_Sampling == LHS_SAMPLING)
+  } else if (m_Sampling == LHS_SAMPLING || m_Sampling == OPTIMIZED_LHS_SAMPLING)
   {
-    m_RNG.LHS(*a, m_InputList);
-    m_RNG.LHS(*b, m_InputList);
+    sampleLHS(*a);
+    sampleLHS(*b);
+    m_RNG.convert(*a, m_InputList);
+    m_RNG.convert(*b, m_InputList);
   } else                                        /* sobol sequence */
   {
-    std::unique_ptr<DMatrix> pilot(new DMatrix(N_, 2*k));
+    std::unique_ptr<DMatrix> pilot(new DMatrix(N, 2*k));
+    m_RNG.setScrambling(m_Sampling == SCRAMBLED_SOBOL_SAMPLING ? replicates_ : 0);
     m_RNG.sobol(*pilot);
     /* copy pilot to a and b */
-    for (int iRow=0; iRow<N_; ++iRow)
+    for (int iRow=0; iRow<N; ++iRow)
     {
       double* row = pilot->getRow(iRow);
       a->fillRow(iRow, row);
       b->fillRow(iRow, &row[k]);
     }
-    pilot.release();
+    pilot.reset();
     /* convert a and b to target distribution */
     m_RNG.convert(*a, m_InputList);
     m_RNG.convert(*b, m_InputList);
   }
 
-  /* 3. Simulate for the input matrices a and b */
-  simulate(*a, *ya);
-  simulate(*b, *yb);
+  /* piece iPiece<nK is c_iPiece, b with the columns of factor iPiece from
+   * a, the next ones d_i, a with the columns of factor i from b */
+  int nK = factorCols_.size();                  /* number of factors or groups */
+  std::unique_ptr<double[]> acol(new double[N]);;
+  auto fill = [&](const int iPiece, DMatrix& c)
+  {
+    (iPiece<nK ? b : a)->copy(c);
+    for (int iCol : factorCols_[iPiece % nK])
+    {
+      (iPiece<nK ? a : b)->copyCol(iCol, acol.get());
+      c.fillCol(iCol, acol.get());
+    }
+  };
 
-  double** yadata = ya->getData();
-  double** ybdata = yb->getData();
-  int* la = ya->getLabels();
-  int* lb = yb->getLabels();
+  if (m_SingleWave)
+  {
+    /* 3. Fills all c and d matrices then simulates the whole design */
+    for (int iPiece=0; iPiece < nPieces; ++iPiece)
+    {
+      std::unique_ptr<DMatrix> c(x->subMatrix((2+iPiece)*N, N));
+      fill(iPiece, *c);
+    }
+    simulate(*x, *y);
 
-  std::unique_ptr<double[]> acol(new double[N_]);;
+    /* 4. For each input, accumulate the sums for all outputs */
+    std::vector<std::unique_ptr<ResultMatrix> > ycs(nPieces);
+    for (int iPiece=0; iPiece < nPieces; ++iPiece)
+    {
+      ycs[iPiece] = std::move(y->subMatrix((2+iPiece)*N, N));
+      if (iPiece < nK)
+        accumulate(iPiece, *ya, *yb, *ycs[iPiece]);
+    }
+    if (secondOrder_)
+      accumulatePairs(ycs);
+  } else
+  {
+    /* 3. Simulate for the input matrices a and b */
+    simulate(*a, *ya);
+    simulate(*b, *yb);
 
-  /* 4. For each input, estimate the sensitivity measures for all outputs */
-  for (int iK=0; iK < k; ++iK)
+    /* 4. For each input, simulates c then accumulates the sums for all
+     * outputs. c is filled in the saved data, otherwise its rows are
+     * composed from b and a when they are simulated. yc is either located
+     * in the saved data or taken from a set of buffers. The outputs of
+     * every piece are kept for second order indices */
+    int nBuffers = secondOrder_ ? nPieces : getNumSlots();
+    std::vector<std::unique_ptr<DMatrix> > cs(nBuffers);
+    std::vector<std::unique_ptr<ResultMatrix> > ycs(nBuffers);
+    for (int iBuf=0; iBuf<nBuffers; ++iBuf)
+    {
+      if (!y)
+        ycs[iBuf].reset(new ResultMatrix(N, m_NumOutputs));
+    }
+    auto buffer = [&](const int iPiece, const int slot)
+    {
+      return secondOrder_ ? iPiece : slot;
+    };
+
+    pipeline(nPieces,
+        [&](const int iPiece, const int slot)
+        {
+          /* Fills content of the saved input matrix c */
+          if (!x)
+            return;
+          int iBuf = buffer(iPiece, slot);
+          cs[iBuf] = std::move(x->subMatrix((2+iPiece)*N, N));
+          fill(iPiece, *cs[iBuf]);
+        },
+        [&](const int iPiece, const int slot)
+        {
+          /* Simulates for the input matrix c */
+          int iBuf = buffer(iPiece, slot);
+          if (y)
+            ycs[iBuf] = std::move(y->subMatrix((2+iPiece)*N, N));
+          if (x)
+            simulate(*cs[iBuf], *ycs[iBuf]);
+          else if (iPiece < nK)
+            simulate(RadialRows(*b, *a, factorCols_[iPiece]), *ycs[iBuf]);
+          else
+            simulate(RadialRows(*a, *b, factorCols_[iPiece-nK]), *ycs[iBuf]);
+        },
+        [&](const int iPiece, const int slot)
+        {
+          if (iPiece < nK)
+            accumulate(iPiece, *ya, *yb, *ycs[buffer(iPiece, slot)]);
+        });
+    if (secondOrder_)
+      accumulatePairs(ycs);
+  }
+}
+
+void SobolSaltelli::accumulate(const int iK, ResultMatrix& ya, ResultMatrix& yb, ResultMatrix& yc)
+{
+  int N = ya.getNumRows();
+  int nOut = m_NumOutputs;
+  int k=getNumFactors();                        /* number of factors or groups */
+  double** yadata = ya.getData();
+  double** ybdata = yb.getData();
+  double** ycdata = yc.getData();
+  int* la = ya.getLabels();
+  int* lb = yb.getLabels();
+  int* lc = yc.getLabels();
+
+  /* 1. Validity of the terms of each sample, the same for all outputs, kept
+   * if resampled */
+  std::vector<char> valid(N);
+  for (int iSample=0; iSample<N; ++iSample)
   {
-    /* Locates where are c and cy if needs */
-    if (m_SaveInput)
+    valid[iSample] = (la[iSample] == SIM_SUCCESS)
+      | (la[iSample] == SIM_SUCCESS && lb[iSample] == SIM_SUCCESS
+          && lc[iSample] == SIM_SUCCESS) << 1
+      | (lb[iSample] == SIM_SUCCESS && lc[iSample] == SIM_SUCCESS) << 2;
+  }
+  if (m_NumBoot>0)
+    masks_[iK].insert(masks_[iK].end(), valid.begin(), valid.end());
+
+  /* 2. The sums of the factor, then of its replicates, are unpacked to one
+   * array per term over the outputs, so that a row of outputs is added lane
+   * by lane in a single pass. Each sum still adds the samples in order */
+  int nReplicates = getNumReplicates();
+  int nSets = 1 + nReplicates;
+  std::vector<double> acc(6*nSets*nOut);        /* term t of set s at (6*s+t)*nOut */
+  std::vector<int> cnts(3*nSets);
+  auto sumsOf = [&](const int iSet)
+  {
+    return iSet == 0 ? &sums_[iK*nOut] : &repSums_[((iSet-1)*k + iK)*nOut];
+  };
+  for (int iSet=0; iSet<nSets; ++iSet)
+  {
+    const Sums_t* sums = sumsOf(iSet);
+    double* a = &acc[6*iSet*nOut];
+    for (int iOut=0; iOut<nOut; ++iOut)
     {
-      c = std::move(m_InputData->subMatrix((2+iK)*N_, N_));     
+      a[iOut] = sums[iOut].ya;
+      a[nOut+iOut] = sums[iOut].yaya;
+      a[2*nOut+iOut] = sums[iOut].dy;
+      a[3*nOut+iOut] = sums[iOut].dydy;
+      a[4*nOut+iOut] = sums[iOut].st;
+      a[5*nOut+iOut] = sums[iOut].stst;
     }
-    if (m_SaveOutput)
+    std::copy(sums[0].cnt, sums[0].cnt+3, &cnts[3*iSet]);
+  }
+
+  /* adds the terms of a sample to a set of sums */
+  auto add = [nOut](double* set, int* cnt, const int valid, const double* ya,
+      const double* dy, const double* st)
+  {
+    if (valid & 1)
     {
-      yc = std::move(m_OutputData->subMatrix((2+iK)*N_, N_));
+      cnt[0]++;
+      for (int iOut=0; iOut<nOut; ++iOut)
+      {
+        set[iOut] += ya[iOut];
+        set[nOut+iOut] += ya[iOut]*ya[iOut];
+      }
     }
+    if (valid & 2)
+    {
+      cnt[1]++;
+      for (int iOut=0; iOut<nOut; ++iOut)
+      {
+        set[2*nOut+iOut] += dy[iOut];
+        set[3*nOut+iOut] += dy[iOut]*dy[iOut];
+      }
+    }
+    if (valid & 4)
+    {
+      cnt[2]++;
+      for (int iOut=0; iOut<nOut; ++iOut)
+      {
+        set[4*nOut+iOut] += st[iOut];
+        set[5*nOut+iOut] += st[iOut]*st[iOut];
+      }
+    }
+  };
 
-    double* sens = m_Sens->getRow(iK);
+  /* the terms of the block are kept output by output */
+  size_t offset = m_NumBoot>0 ? terms_[iK*nOut].size() : 0;
+  if (m_NumBoot>0)
+  {
+    for (int iOut=0; iOut<nOut; ++iOut)
+      terms_[iK*nOut + iOut].resize(offset + 3*(size_t) N);
+  }
 
-    /* Fills content of the input matrix c */
-    b->copy(*c);
-    a->copyCol(iK, acol.get());
-    c->fillCol(iK, acol.get());
-    
-    /* Simulates for the input matrix c */
-    simulate(*c, *yc);
-    
-    /* Estimates sensitivity indices */
-    double** ycdata = yc->getData();
-    int* lc = yc->getLabels();
-    for (int iOut=0; iOut < m_NumOutputs; ++ iOut)
+  /* 3. One pass over the samples: the terms of all outputs, 0 if invalid,
+   * then the sums */
+  std::vector<double> dy(nOut), st(nOut);
+  for (int iSample=0; iSample<N; ++iSample)
+  {
+    const double* a = yadata[iSample];
+    const double* b = ybdata[iSample];
+    const double* c = ycdata[iSample];
+    int v = valid[iSample];
+
+    if (v & 2)
+    {
+      for (int iOut=0; iOut<nOut; ++iOut)
+        dy[iOut] = (c[iOut] - b[iOut]) * a[iOut];
+    } else
+      std::fill(dy.begin(), dy.end(), 0.0);
+
+    if (!(v & 4))
+      std::fill(st.begin(), st.end(), 0.0);
+    else if (estimator_ == SOBOL2002)
+    {
+      for (int iOut=0; iOut<nOut; ++iOut)
+        st[iOut] = b[iOut] * c[iOut];
+    } else if (estimator_ == SOBOL2007)
+    {
+      for (int iOut=0; iOut<nOut; ++iOut)
+        st[iOut] = (b[iOut]-c[iOut]) * b[iOut];
+    } else
     {
-      /* calculate f0 and ya.ya, ya.yc and yb.yc for output iOut*/
-      double f0 = 0;
-      double D = 0;
-      double Eyt1 = 0;
-      double Eyt2 = 0;
-      double Dy=0;
-      double ybyc = 0;
-
-      int validCnt[3] = {0, 0, 0};                         /* number of valid simulation
-                                                   results */
-      for (int iSample=0; iSample<N_; ++iSample)
+      for (int iOut=0; iOut<nOut; ++iOut)
+        st[iOut] = (b[iOut]-c[iOut]) * (b[iOut]-c[iOut]);
+    }
+
+    /* samples of the block belong to the replicates in turn */
+    add(&acc[0], &cnts[0], v, a, dy.data(), st.data());
+    if (nReplicates>0)
+    {
+      int iSet = 1 + (firstRow_ + iSample) % nReplicates;
+      add(&acc[6*iSet*nOut], &cnts[3*iSet], v, a, dy.data(), st.data());
+    }
+
+    if (m_NumBoot>0)
+    {
+      for (int iOut=0; iOut<nOut; ++iOut)
       {
-        if (la[iSample] == SIM_SUCCESS)
-        {
-          validCnt[0]++;
-          f0 += yadata[iSample][iOut];
-          D +=  yadata[iSample][iOut] * yadata[iSample][iOut];
-        }
+        double* terms = &terms_[iK*nOut + iOut][offset + 3*(size_t) iSample];
+        terms[0] = a[iOut];
+        terms[1] = dy[iOut];
+        terms[2] = st[iOut];
+      }
+    }
+  }
 
+  /* 4. Packs the sums back */
+  for (int iSet=0; iSet<nSets; ++iSet)
+  {
+    Sums_t* sums = sumsOf(iSet);
+    const double* a = &acc[6*iSet*nOut];
+    for (int iOut=0; iOut<nOut; ++iOut)
+    {
+      sums[iOut].ya = a[iOut];
+      sums[iOut].yaya = a[nOut+iOut];
+      sums[iOut].dy = a[2*nOut+iOut];
+      sums[iOut].dydy = a[3*nOut+iOut];
+      sums[iOut].st = a[4*nOut+iOut];
+      sums[iOut].stst = a[5*nOut+iOut];
+      std::copy(&cnts[3*iSet], &cnts[3*iSet]+3, sums[iOut].cnt);
+    }
+  }
+}
 
-        if (la[iSample] == SIM_SUCCESS
-            && lc[iSample] == SIM_SUCCESS
-            && lb[iSample] == SIM_SUCCESS)
-        {
-          Dy += (ycdata[iSample][iOut] - ybdata[iSample][iOut]) * yadata[iSample][iOut];
-          validCnt[1]++;
-        }
+void SobolSaltelli::accumulatePairs(std::vector<std::unique_ptr<ResultMatrix> >& ys)
+{
+  int k=getNumFactors();                        /* number of factors or groups */
+  int nOut = m_NumOutputs;
+  int N = ys[0]->getNumRows();
 
-        if (lb[iSample] == SIM_SUCCESS
-            && lc[iSample] == SIM_SUCCESS)
+  /* d_i and c_j share factors i and j only, so do d_j and c_i */
+  int iPair = 0;
+  for (int iK=0; iK < k; ++iK)
+  {
+    for (int jK=iK+1; jK < k; ++jK, ++iPair)
+    {
+      double* sums = &pairSums_[iPair*nOut];
+      for (int iSide=0; iSide<2; ++iSide)
+      {
+        ResultMatrix& yd = *ys[k + (iSide == 0 ? iK : jK)];
+        ResultMatrix& yc = *ys[iSide == 0 ? jK : iK];
+        int* ld = yd.getLabels();
+        int* lc = yc.getLabels();
+        for (int iSample=0; iSample<N; ++iSample)
         {
-          ybyc += ybdata[iSample][iOut] * ycdata[iSample][iOut];
-          Eyt1 += (ybdata[iSample][iOut]-ycdata[iSample][iOut]) * ybdata[iSample][iOut];
-          Eyt2 += (ybdata[iSample][iOut]-ycdata[iSample][iOut]) *  (ybdata[iSample][iOut]-ycdata[iSample][iOut]);
-            
-          validCnt[2]++;
+          if (ld[iSample] != SIM_SUCCESS || lc[iSample] != SIM_SUCCESS)
+            continue;
+          const double* d = yd.getRow(iSample);
+          const double* c = yc.getRow(iSample);
+          for (int iOut=0; iOut<nOut; ++iOut)
+            sums[iOut] += (d[iOut]-c[iOut]) * (d[iOut]-c[iOut]);
+          pairCnts_[iPair]++;
         }
       }
+    }
+  }
+}
+
+double SobolSaltelli::estimate(const int N)
+{
+  int k=getNumFactors();                        /* number of factors or groups */
+  double minCnt = (1-m_FailureRate) * N;
+  double width = 0;
+  std::vector<double> variances(k*m_NumOutputs);
+
+  for (int iK=0; iK < k; ++iK)
+  {
+    double* sens = m_Sens->getRow(iK);
+    for (int iOut=0; iOut < m_NumOutputs; ++ iOut)
+    {
+      const Sums_t& sums = sums_[iK*m_NumOutputs + iOut];
+      const int* validCnt = sums.cnt;
 
       /* check if the number if valid results is acceptable*/
       if (validCnt[0] < minCnt
@@ -185,29 +621,141 @@ void SobolSaltelli::doSA()
         throw SAException(ERROR_EXCEEDING_FAILURE_RATE);
       }
 
-      f0 = f0/validCnt[0];
-      f0 *= f0;
-      D /= validCnt[0];
-      D -= f0;
-
-      Dy /= validCnt[1];
-      Eyt1 /= validCnt[2];
-      Eyt2 /= 2*validCnt[2];
-      ybyc /= validCnt[2];
-      /* now estimate S[iOut] and St[iOut] */
-      sens[2*iOut] = Dy/D;
-      if (estimator_ == SOBOL2002)
+      double D = indices(sums, &sens[2*iOut]);
+      variances[iK*m_NumOutputs + iOut] = D;
+      double Dy = sums.dy/validCnt[1];
+      double st = sums.st/validCnt[2];
+
+      /* half widths of the asymptotic 95% confidence intervals, taking D
+       * as exact */
+      double varDy = sums.dydy/validCnt[1] - Dy*Dy;
+      double varSt = sums.stst/validCnt[2] - st*st;
+      if (estimator_ == SOBOL2010)
+        varSt /= 4;
+      double wS = 1.96*std::sqrt(std::fmax(varDy, 0)/validCnt[1])/std::fabs(D);
+      double wSt = 1.96*std::sqrt(std::fmax(varSt, 0)/validCnt[2])/std::fabs(D);
+      width = std::fmax(width, std::fmax(wS, wSt));
+    }
+  }
+
+  /* second order indices: the closed index of a pair, from the mean
+   * squared difference of its outputs as in Jansen, less the first order
+   * indices */
+  if (sens2_)
+  {
+    int iPair = 0;
+    for (int iK=0; iK < k; ++iK)
+    {
+      for (int jK=iK+1; jK < k; ++jK, ++iPair)
       {
-        sens[2*iOut+1] = 1-(ybyc-f0)/D; /* sobol 2002 */
-      } else if (estimator_ == SOBOL2007)
+        if (pairCnts_[iPair] < 2*minCnt)
+          throw SAException(ERROR_EXCEEDING_FAILURE_RATE);
+        double* row = sens2_->getRow(iPair);
+        for (int iOut=0; iOut < m_NumOutputs; ++iOut)
+        {
+          double D = variances[iK*m_NumOutputs + iOut];
+          double closed = 1 - pairSums_[iPair*m_NumOutputs + iOut]/(2*pairCnts_[iPair])/D;
+          row[iOut] = closed - m_Sens->getRow(iK)[2*iOut] - m_Sens->getRow(jK)[2*iOut];
+        }
+      }
+    }
+  }
+  return width;
+}
+
+double SobolSaltelli::estimateStdErr()
+{
+  int k=getNumFactors();                        /* number of factors or groups */
+  int nReplicates = getNumReplicates();
+  std::vector<double> sens(2*nReplicates);
+  double maxErr = 0;
+
+  for (int iK=0; iK < k; ++iK)
+  {
+    double* err = stdErr_->getRow(iK);
+    for (int iOut=0; iOut < m_NumOutputs; ++ iOut)
+    {
+      /* 1. Indices of each replicate */
+      for (int iRep=0; iRep<nReplicates; ++iRep)
+        indices(repSums_[(iRep*k + iK)*m_NumOutputs + iOut], &sens[2*iRep]);
+
+      /* 2. Standard errors of their means */
+      for (int j=0; j<2; ++j)
       {
-      sens[2*iOut+1] = Eyt1/D;                   /* sobol 2007 */
-      } else
+        double mean = 0, var = 0;
+        for (int iRep=0; iRep<nReplicates; ++iRep)
+          mean += sens[2*iRep+j];
+        mean /= nReplicates;
+        for (int iRep=0; iRep<nReplicates; ++iRep)
+          var += (sens[2*iRep+j]-mean) * (sens[2*iRep+j]-mean);
+        var /= nReplicates-1;
+        err[2*iOut+j] = std::sqrt(var/nReplicates);
+        maxErr = std::fmax(maxErr, err[2*iOut+j]);
+      }
+    }
+  }
+  return maxErr;
+}
+
+double SobolSaltelli::indices(const Sums_t& sums, double* sens) const
+{
+  const int* validCnt = sums.cnt;
+  double f0 = sums.ya/validCnt[0];
+  f0 *= f0;
+  double D = sums.yaya/validCnt[0];
+  D -= f0;
+
+  double Dy = sums.dy/validCnt[1];
+  double st = sums.st/validCnt[2];
+  /* now estimate S and St */
+  sens[0] = Dy/D;
+  if (estimator_ == SOBOL2002)
+  {
+    sens[1] = 1-(st-f0)/D;                      /* sobol 2002 */
+  } else if (estimator_ == SOBOL2007)
+  {
+    sens[1] = st/D;                             /* sobol 2007 */
+  } else
+  {
+    sens[1] = sums.st/(2*validCnt[2])/D;        /* sobol 2010 */
+  }
+  return D;
+}
+
+void SobolSaltelli::resample(const int* units, DMatrix& sens) const
+{
+  int k=getNumFactors();                        /* number of factors or groups */
+  for (int iK=0; iK < k; ++iK)
+  {
+    const char* mask = masks_[iK].data();
+    double* row = sens.getRow(iK);
+    for (int iOut=0; iOut < m_NumOutputs; ++iOut)
+    {
+      const double* terms = terms_[iK*m_NumOutputs + iOut].data();
+      Sums_t sums = {};
+      for (int iUnit=0; iUnit<usedN_; ++iUnit)
       {
-        sens[2*iOut+1] = Eyt2/D;                   /* sobol 2010 */
+        int iSample = units[iUnit];
+        const double* t = &terms[3*iSample];
+        if (mask[iSample] & 1)
+        {
+          sums.cnt[0]++;
+          sums.ya += t[0];
+          sums.yaya += t[0]*t[0];
+        }
+        if (mask[iSample] & 2)
+        {
+          sums.cnt[1]++;
+          sums.dy += t[1];
+        }
+        if (mask[iSample] & 4)
+        {
+          sums.cnt[2]++;
+          sums.st += t[2];
+        }
       }
+      indices(sums, &row[2*iOut]);
     }
   }
 }
 BIO_NAMESPACE_END
-
@@ -0,0 +1,135 @@
+/**
+ @file WorkerPool.cpp
+ @brief Implementation for WorkerPool class
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#include "WorkerPool.h"
+
+#include <atomic>
+#include <exception>
+#include <thread>
+
+BIO_NAMESPACE_BEGIN
+
+WorkerPool::WorkerPool(const int nthreads)
+  : m_NumThreads(nthreads > 0 ? nthreads : getHardwareThreads())
+  , m_Interleaved(false)
+{
+  for (int i=0; i<m_NumThreads; ++i)
+    m_Queues.push_back(std::unique_ptr<Queue>(new Queue()));
+}
+
+int WorkerPool::getNumThreads() const
+{
+  return m_NumThreads;
+}
+
+void WorkerPool::setInterleaved(const bool interleaved)
+{
+  m_Interleaved = interleaved;
+}
+
+int WorkerPool::getHardwareThreads()
+{
+  int ret = std::thread::hardware_concurrency();
+  return ret > 0 ? ret : 1;
+}
+
+bool WorkerPool::next(const int worker, int& chunk)
+{
+  /* 1. Takes from the front of its own queue */
+  {
+    Queue* own = m_Queues[worker].get();
+    std::lock_guard<std::mutex> guard(own->lock);
+    if (!own->chunks.empty())
+    {
+      chunk = own->chunks.front();
+      own->chunks.pop_front();
+      return true;
+    }
+  }
+
+  /* 2. Steals from the back of the other queues */
+  for (int i=1; i<m_NumThreads; ++i)
+  {
+    Queue* victim = m_Queues[(worker+i) % m_NumThreads].get();
+    std::lock_guard<std::mutex> guard(victim->lock);
+    if (!victim->chunks.empty())
+    {
+      chunk = victim->chunks.back();
+      victim->chunks.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkerPool::run(const int n, const int chunk, Task_t task)
+{
+  if (n<=0)
+    return;
+
+  int chunkSize = chunk > 0 ? chunk : 1;
+  int nChunks = (n + chunkSize - 1) / chunkSize;
+  int nWorkers = m_NumThreads < nChunks ? m_NumThreads : nChunks;
+
+  /* Runs on the calling thread if there is nothing to share */
+  if (nWorkers == 1)
+  {
+    for (int iChunk=0; iChunk<nChunks; ++iChunk)
+    {
+      int begin = iChunk*chunkSize;
+      task(0, begin, begin+chunkSize < n ? begin+chunkSize : n);
+    }
+    return;
+  }
+
+  /* 1. Deals contiguous blocks of chunks (or single chunks in turn) to the
+   * workers */
+  for (int iW=0; iW<m_NumThreads; ++iW)
+    m_Queues[iW]->chunks.clear();
+  for (int iChunk=0; iChunk<nChunks; ++iChunk)
+  {
+    int iW = m_Interleaved ? iChunk % nWorkers : (long long) iChunk * nWorkers / nChunks;
+    m_Queues[iW]->chunks.push_back(iChunk);
+  }
+
+  std::atomic<bool> failed(false);
+  std::exception_ptr error(nullptr);
+  std::mutex errorLock;
+
+  auto work = [&](const int worker)
+  {
+    int iChunk = 0;
+    while (!failed && next(worker, iChunk))
+    {
+      int begin = iChunk*chunkSize;
+      try
+      {
+        task(worker, begin, begin+chunkSize < n ? begin+chunkSize : n);
+      } catch (...)
+      {
+        std::lock_guard<std::mutex> guard(errorLock);
+        if (!failed)
+        {
+          error = std::current_exception();
+          failed = true;
+        }
+      }
+    }
+  };
+
+  /* 2. Starts the workers, the calling thread acts as worker 0 */
+  std::vector<std::thread> threads;
+  for (int iW=1; iW<nWorkers; ++iW)
+    threads.push_back(std::thread(work, iW));
+  work(0);
+  for (auto& t : threads)
+    t.join();
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
+BIO_NAMESPACE_END
@@ -10,6 +10,7 @@
 #include <cvode/cvode_dense.h>
 
 #include "common/CommonDefs.h"
+#include "common/CancelToken.h"
 #include "OdeModel.h"
 #include "CvodeHelper.h"
 #include "CvodeSettings.h"
@@ -92,6 +93,13 @@ int CvodeSolver::solve(const double endTime)
     }
     
 
+    /* give up if the token has been stopped */
+    if (m_Token && m_Token->isStopped())
+    {
+      ret = m_Token->getStatus();
+      break;
+    }
+
     /* call CVode to move integration forward */
     int mode = isMoveOneInternalStep_ ? CV_ONE_STEP : CV_NORMAL;
 
@@ -113,8 +121,8 @@ int CvodeSolver::solve(const double endTime)
           ret = helperUpdate(tout);
         break;
       default:
-        /* error  */
-        ret = SATOOLS_FAILURE;
+        /* error, possibly raised by f() when the token has been stopped */
+        ret = (m_Token && m_Token->isStopped()) ? m_Token->getStatus() : SATOOLS_FAILURE;
     }
   }
   return ret;
@@ -170,14 +178,14 @@ int CvodeSolver::createSolverStructure(const SolverSettings* settings)
   bool success = ( cvode_ != nullptr );
 
   if (success)
-    success = ( CVodeInit(cvode_, CvodeHelper::f, m_CurrentTime, y_) 
+    success = ( CVodeInit(cvode_, CvodeSolver::f, m_CurrentTime, y_) 
                   == CV_SUCCESS );
 
   if (success)
     success = ( CVodeSVtolerances(cvode_, cvodeSettings->getRError(), atols_) 
                   == CV_SUCCESS );
   if (success)
-    success = ( CVodeSetUserData(cvode_, m_Helper.get())
+    success = ( CVodeSetUserData(cvode_, this)
                   == CV_SUCCESS );
   if (success)
     success = ( CVodeSetErrHandlerFn(cvode_, CvodeSolver::errorHandler, this)
@@ -192,7 +200,7 @@ int CvodeSolver::createSolverStructure(const SolverSettings* settings)
     success = ( CVodeSetMaxNumSteps(cvode_, cvodeSettings->getMaxSteps())
                   == CV_SUCCESS );
   if (success)
-    success = ( CVodeRootInit(cvode_, m_Helper->getNumRootFinders(), CvodeHelper::g)
+    success = ( CVodeRootInit(cvode_, m_Helper->getNumRootFinders(), CvodeSolver::g)
                   == CV_SUCCESS );
 
   return success ? SATOOLS_SUCCESS : SATOOLS_FAILURE;
@@ -218,6 +226,21 @@ CvodeHelper* CvodeSolver::createSolverHelper()
   return new CvodeHelper(m_Model, m_Errors);  
 }
 
+int CvodeSolver::f(realtype t, N_Vector y, N_Vector ydot, void *f_data)
+{
+  CvodeSolver* solver = (CvodeSolver*) f_data;
+  /* a negative value makes CVode stop with an unrecoverable error */
+  if (solver->m_Token && solver->m_Token->isStopped())
+    return -1;
+  return CvodeHelper::f(t, y, ydot, solver->m_Helper.get());
+}
+
+int CvodeSolver::g(realtype t, N_Vector y, realtype* gout, void *g_data)
+{
+  CvodeSolver* solver = (CvodeSolver*) g_data;
+  return CvodeHelper::g(t, y, gout, solver->m_Helper.get());
+}
+
 void CvodeSolver::errorHandler(int error_code
         , const char* module, const char* function
         , char* msg, void* eh_data)
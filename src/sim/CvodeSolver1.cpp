@@ -12,6 +12,8 @@
 #include <iostream>
 
 #include "common/Logger.h"
+#include "common/CommonDefs.h"
+#include "common/CancelToken.h"
 
 #include <cvode/cvode.h>
 #include <cvode/cvode_dense.h>
@@ -70,7 +72,7 @@ void CvodeSolver1::doInitialize()
   cvode_ = CVodeCreate(CV_BDF, CV_NEWTON);
   CVodeInit(cvode_, CvodeSolver1::f, m_Time, y_);
   CVodeSVtolerances(cvode_, settings->getRError(), atols_) ;
-  CVodeSetUserData(cvode_, m_Data);
+  CVodeSetUserData(cvode_, this);
   CVodeSetErrHandlerFn(cvode_, CvodeSolver1::handleError, this);
   CVDense(cvode_, m_NumOdes);
   CVDlsSetDenseJacFn(cvode_, nullptr);
@@ -86,7 +88,19 @@ void CvodeSolver1::doReset()
 void CvodeSolver1::solve(const double tout)
 {
   //TODO: handler trigger (need root finder)
-  CVode(cvode_, tout, y_, &m_Time, CV_NORMAL);
+  const CancelToken* token = getCancelToken();
+  if (token == nullptr || !token->isStopped())
+    CVode(cvode_, tout, y_, &m_Time, CV_NORMAL);
+
+  /* f() makes CVode give up once the token is stopped */
+  if (token && token->isStopped())
+  {
+    int code = token->getStatus();
+    m_Errors.add(new ErrorMessage(code,
+          code == ERROR_TIME_BUDGET_EXCEEDED ? "the simulation ran past its time budget"
+                                             : "the simulation was cancelled"));
+    return;
+  }
   m_Data->update(tout, NV_DATA_S(y_));
 }
 
@@ -97,8 +111,12 @@ double* CvodeSolver1::getY()
 
 int CvodeSolver1::f(double t, N_Vector y, N_Vector ydot, void* fdata)
 {
-  SolverData* eval = (SolverData*) fdata;
-  return eval->f(t, NV_DATA_S(y), NV_DATA_S(ydot));
+  CvodeSolver1* solver = (CvodeSolver1*) fdata;
+  /* a negative value makes CVode stop with an unrecoverable error */
+  const CancelToken* token = solver->getCancelToken();
+  if (token && token->isStopped())
+    return -1;
+  return solver->m_Data->f(t, NV_DATA_S(y), NV_DATA_S(ydot));
 }
 
 
@@ -30,6 +30,10 @@ const SolverSettings* InnerSolver::getSettings() const
   return wrapper_->m_Settings;
 }
 
+const CancelToken* InnerSolver::getCancelToken() const
+{
+  return wrapper_->m_Token;
+}
 
 const OdeStruct* InnerSolver::getModel()
 {
@@ -17,6 +17,7 @@ Solver::Solver(const SolverSettings* settings)
   , m_Settings(settings)
   , m_Model(nullptr)
   , m_Solver(nullptr)
+  , m_Token(nullptr)
 {
 }
 void Solver::checkErrors()
@@ -82,6 +83,11 @@ void Solver::solve(const double tout)
   // if the solver successfully advance to 'time' update solver data
 }
 
+void Solver::setCancelToken(const CancelToken* token)
+{
+  m_Token = token;
+}
+
 BIO_NAMESPACE_END
 
 
@@ -23,6 +23,7 @@ SolverBase::SolverBase(const OdeModel& model)
     , m_Helper(nullptr)
     , m_Errors()
     , m_CurrentTime(0)
+    , m_Token(nullptr)
 {
 }
 
@@ -35,6 +36,11 @@ const double* SolverBase::getValues() const
   m_Helper->getValues();
 }
 
+void SolverBase::setCancelToken(const CancelToken* token)
+{
+  m_Token = token;
+}
+
 const SolverError& SolverBase:: getErrors() const
 {
   return m_Errors;
@@ -0,0 +1,171 @@
+/**
+ @file testcheckpoint.cpp
+ @brief Checks that an analysis cancelled while checkpointing resumes to the
+ indices of an uninterrupted run
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <common/CommonDefs.h>
+#include <sens/SA.h>
+
+using namespace reo;
+
+namespace
+{
+  const double MY_PI = 3.141592653589793238462643383279502884;
+  const char* CHECKPOINT = "testcheckpoint.ckpt";
+
+  /* Ishigami function and a second output, so that the records hold more
+   * than one value. Samples with x1 > 3 fail. The analysis is cancelled
+   * once the model has been called cancelAt times */
+  class CancellingModel : public ModelEvaluator
+  {
+    public:
+      CancellingModel(SABase* sa, std::atomic<int>* calls, const int cancelAt)
+        : ModelEvaluator(3, 2)
+        , sa_(sa)
+        , calls_(calls)
+        , cancelAt_(cancelAt)
+      {
+      }
+
+      int solve(const double* x, double* y) const
+      {
+        if (++*calls_ == cancelAt_)
+          sa_->cancel();
+        y[0] = sin(x[0]) + 7*pow(sin(x[1]), 2) + 0.1*pow(x[2], 4)*sin(x[0]);
+        y[1] = x[0]*x[2] + x[1];
+        return x[1] > 3 ? 1 : SATOOLS_SUCCESS;
+      }
+    private:
+      SABase* sa_;
+      std::atomic<int>* calls_;
+      int cancelAt_;
+  };
+
+  typedef std::function<SABase* ()> Factory_t;
+
+  /* Configures a seeded analysis cancelled after cancelAt calls, -1 to let
+   * it complete */
+  void setup(SABase& sa, const ModelInputList& inputs, const SamplingMethod_t sampling,
+      std::atomic<int>& calls, const int cancelAt)
+  {
+    sa.setModelInputList(&inputs);
+    sa.setNumOutputs(2);
+    sa.setSamplingMethod(sampling);
+    sa.setFailureRate(0.2);
+    sa.setSeed(2024);
+    sa.setNumThreads(3);
+    sa.setChunkSize(4);
+    sa.setBootstrap(20);
+    SABase* p = &sa;
+    sa.setEval([p, &calls, cancelAt](void*)
+        {
+          return std::shared_ptr<ModelEvaluator>(new CancellingModel(p, &calls, cancelAt));
+        });
+  }
+
+  bool same(const DMatrix* a, const DMatrix* b)
+  {
+    if (a == nullptr || b == nullptr)
+      return a == b;
+    if (a->getNumRows() != b->getNumRows() || a->getNumCols() != b->getNumCols())
+      return false;
+    for (int iRow=0; iRow<a->getNumRows(); ++iRow)
+    {
+      for (int iCol=0; iCol<a->getNumCols(); ++iCol)
+      {
+        double x = a->getRow(iRow)[iCol];
+        double y = b->getRow(iRow)[iCol];
+        if (!(x == y || (std::isnan(x) && std::isnan(y))))
+          return false;
+      }
+    }
+    return true;
+  }
+
+  /* Returns true if the resumed run reproduces the uninterrupted one */
+  bool check(const std::string& name, Factory_t create, const ModelInputList& inputs,
+      const SamplingMethod_t sampling, const int cancelAt)
+  {
+    std::atomic<int> calls(0);
+
+    /* 1. The uninterrupted run */
+    std::unique_ptr<SABase> ref(create());
+    setup(*ref, inputs, sampling, calls, -1);
+    ref->analyze();
+    int total = calls;
+
+    /* 2. The run cancelled part way, logging to the checkpoint */
+    calls = 0;
+    bool cancelled = false;
+    {
+      std::unique_ptr<SABase> sa(create());
+      setup(*sa, inputs, sampling, calls, cancelAt);
+      sa->setCheckpoint(CHECKPOINT);
+      try
+      {
+        sa->analyze();
+      } catch (SAException&)
+      {
+        cancelled = true;
+      }
+    }
+
+    /* 3. Its continuation from the checkpoint, by a fresh analysis */
+    calls = 0;
+    std::unique_ptr<SABase> resumed(create());
+    setup(*resumed, inputs, sampling, calls, -1);
+    resumed->resume(CHECKPOINT);
+    int resumedCalls = calls;
+    std::remove(CHECKPOINT);
+
+    bool ok = cancelled && resumedCalls < total
+      && same(ref->getSens(), resumed->getSens())
+      && same(ref->getSensCI(), resumed->getSensCI());
+    std::cout << name << " sampling " << sampling << ": " << total << " calls, "
+      << resumedCalls << " after resuming, " << (ok ? "ok" : "FAILED") << "\n";
+    return ok;
+  }
+}
+
+int main()
+{
+  ModelInputList inputs;
+  inputs.add("x0").setUniform(-MY_PI, MY_PI);
+  inputs.add("x1").setUniform(-MY_PI, MY_PI);
+  inputs.add("x2").setUniform(-MY_PI, MY_PI);
+
+  int failures = 0;
+  for (SamplingMethod_t sampling : {MC_SAMPLING, LHS_SAMPLING, SCRAMBLED_SOBOL_SAMPLING})
+  {
+    failures += !check("SobolSaltelli", []()
+        {
+          SobolSaltelli* sa = new SobolSaltelli();
+          sa->setN(500);
+          return sa;
+        }, inputs, sampling, 1200);
+    failures += !check("DGSM", []()
+        {
+          DGSM* sa = new DGSM();
+          sa->setN(500);
+          return sa;
+        }, inputs, sampling, 900);
+  }
+  failures += !check("Morris", []()
+      {
+        Morris* sa = new Morris();
+        sa->setR(50);
+        return sa;
+      }, inputs, LHS_SAMPLING, 100);
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
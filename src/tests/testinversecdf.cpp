@@ -0,0 +1,158 @@
+/**
+ @file testinversecdf.cpp
+ @brief Checks the batch inverse-CDF kernels against the scalar functions
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sens/InverseCDF.h>
+#include <sens/ModelInput.h>
+#include <sens/RNGWrapper.h>
+#include <sens/normal.h>
+
+using namespace reo;
+
+namespace
+{
+  typedef std::function<void (double*, const int)> Kernel_t;
+  typedef std::function<double (const double)> Scalar_t;
+
+  /* sizes around the blocks of normal01 (256) and of convert (4096) */
+  const int SIZES[] = {1, 3, 255, 256, 257, 4095, 4096, 4097, 8192 + 77};
+
+  /* probabilities in the tails and around the switch of normal01 from the
+   * central approximation to the scalar path at |p-0.5| = 0.425 */
+  const double TAILS[] = {0, 1e-300, 1e-30, 1e-12, 1e-6, 0.001, 0.02425,
+    0.075, std::nextafter(0.075, 0.0), std::nextafter(0.075, 1.0), 0.5,
+    0.925, std::nextafter(0.925, 0.0), std::nextafter(0.925, 1.0), 0.999,
+    1-1e-6, 1-1e-12, std::nextafter(1.0, 0.0), 1};
+
+  /* Uniform values with the tail values spread over the blocks */
+  std::vector<double> probabilities(const int n, std::mt19937_64& rng)
+  {
+    std::uniform_real_distribution<double> dis(0, 1);
+    std::vector<double> values(n);
+    for (int i=0; i<n; ++i)
+      values[i] = dis(rng);
+    int nTails = sizeof(TAILS)/sizeof(TAILS[0]);
+    for (int i=0; i<n && i<nTails; ++i)
+      values[(i*7919L) % n] = TAILS[i];
+    if (n>1)
+      values[n-1] = TAILS[(n-1) % nTails];
+    return values;
+  }
+
+  bool same(const double a, const double b)
+  {
+    return a == b || (std::isnan(a) && std::isnan(b));
+  }
+
+  /* Returns the number of values where the kernel and the scalar function
+   * differ */
+  int check(const std::string& name, Kernel_t kernel, Scalar_t scalar,
+      std::mt19937_64& rng)
+  {
+    int mismatches = 0;
+    for (int n : SIZES)
+    {
+      std::vector<double> values = probabilities(n, rng);
+      std::vector<double> out(values);
+      kernel(out.data(), n);
+      for (int i=0; i<n; ++i)
+      {
+        double expected = scalar(values[i]);
+        if (!same(out[i], expected))
+        {
+          if (mismatches < 5)
+            std::cout << name << ": n=" << n << " p=" << values[i]
+              << " got " << out[i] << " expected " << expected << "\n";
+          mismatches++;
+        }
+      }
+    }
+    std::cout << name << ": " << mismatches << " mismatches\n";
+    return mismatches;
+  }
+}
+
+int main()
+{
+  std::cout.precision(17);
+  std::mt19937_64 rng(2024);
+  int mismatches = 0;
+
+  /* 1. The kernels against the scalar functions of normal.h */
+  double lower = 0.1, upper = 250;
+  double mean = 1.5, std = 0.7, a = mean - 3*std, b = mean + 3*std;
+
+  mismatches += check("uniform",
+      [=](double* v, const int n) { InverseCDF::uniform(v, n, lower, upper); },
+      [=](const double p) { return p*(upper-lower) + lower; }, rng);
+  mismatches += check("logUniform",
+      [=](double* v, const int n) { InverseCDF::logUniform(v, n, lower, upper); },
+      [=](const double p)
+      {
+        double ll = log10(lower);
+        return pow(10, p*(log10(upper) - ll) + ll);
+      }, rng);
+  mismatches += check("truncatedNormal",
+      [=](double* v, const int n) { InverseCDF::truncatedNormal(v, n, mean, std, a, b); },
+      [=](const double p) { return truncated_normal_ab_cdf_inv(p, mean, std, a, b); }, rng);
+  mismatches += check("truncatedLogNormal",
+      [=](double* v, const int n) { InverseCDF::truncatedLogNormal(v, n, mean, std, a, b); },
+      [=](const double p) { return pow(10, truncated_normal_ab_cdf_inv(p, mean, std, a, b)); },
+      rng);
+  mismatches += check("normal01",
+      [](double* v, const int n) { InverseCDF::normal01(v, n); },
+      [](const double p) { return normal_01_cdf_inv(p); }, rng);
+
+  /* 2. RNGWrapper::convert() on row counts around its blocks, at one and
+   * several threads */
+  ModelInputList inputs;
+  inputs.add("u").setUniform(lower, upper);
+  inputs.add("logu").setUniform(lower, upper).setLog();
+  inputs.add("n").setNormal(mean, std);
+  inputs.add("logn").setNormal(mean, std).setLog();
+  std::vector<Scalar_t> scalars = {
+    [=](const double p) { return p*(upper-lower) + lower; },
+    [=](const double p)
+    {
+      double ll = log10(lower);
+      return pow(10, p*(log10(upper) - ll) + ll);
+    },
+    [=](const double p) { return truncated_normal_ab_cdf_inv(p, mean, std, a, b); },
+    [=](const double p) { return pow(10, truncated_normal_ab_cdf_inv(p, mean, std, a, b)); }
+  };
+  int convertMismatches = 0;
+  for (int nThreads : {1, 3})
+  {
+    RNGWrapper wrapper;
+    wrapper.setNumThreads(nThreads);
+    for (int n : SIZES)
+    {
+      DMatrix mat(n, inputs.size());
+      for (int iCol=0; iCol<inputs.size(); ++iCol)
+        mat.fillCol(iCol, probabilities(n, rng).data());
+      DMatrix orig(mat);
+      wrapper.convert(mat, &inputs);
+      for (int iRow=0; iRow<n; ++iRow)
+      {
+        for (int iCol=0; iCol<inputs.size(); ++iCol)
+        {
+          if (!same(mat.getRow(iRow)[iCol], scalars[iCol](orig.getRow(iRow)[iCol])))
+            convertMismatches++;
+        }
+      }
+    }
+  }
+  std::cout << "convert: " << convertMismatches << " mismatches\n";
+  mismatches += convertMismatches;
+
+  return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
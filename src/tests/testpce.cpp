@@ -0,0 +1,140 @@
+/**
+ @file testpce.cpp
+ @brief Checks the PCE indices of functions with analytic indices
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#include <cmath>
+#include <iostream>
+#include <string>
+
+#include <common/CommonDefs.h>
+#include <sens/SA.h>
+
+using namespace reo;
+
+namespace
+{
+  const double MY_PI = 3.141592653589793238462643383279502884;
+
+  /* Ishigami function with a=7, b=0.1 */
+  class IshigamiModel : public ModelEvaluator
+  {
+    public:
+      IshigamiModel()
+        : ModelEvaluator(3, 1)
+      {
+      }
+
+      int solve(const double* x, double* y) const
+      {
+        y[0] = sin(x[0]) + 7*pow(sin(x[1]), 2) + 0.1*pow(x[2], 4)*sin(x[0]);
+        return SATOOLS_SUCCESS;
+      }
+  };
+
+  /* A polynomial of standard normal inputs, expanded exactly by degree 2,
+   * and a constant output */
+  class PolynomialModel : public ModelEvaluator
+  {
+    public:
+      PolynomialModel()
+        : ModelEvaluator(3, 2)
+      {
+      }
+
+      int solve(const double* x, double* y) const
+      {
+        y[0] = x[0] + 2*x[1] + x[0]*x[2];
+        y[1] = 5;
+        return SATOOLS_SUCCESS;
+      }
+  };
+
+  /* Counts the values farther than tol from the expected ones */
+  int compare(const std::string& name, const double value, const double expected,
+      const double tol)
+  {
+    bool ok = fabs(value - expected) <= tol;
+    std::cout << name << ": " << value << " expected " << expected
+      << (ok ? "" : " FAILED") << "\n";
+    return ok ? 0 : 1;
+  }
+}
+
+int main()
+{
+  int failures = 0;
+
+  /* 1. Ishigami function, whose indices are known in closed form */
+  {
+    double a = 7, b = 0.1;
+    double V1 = 0.5*pow(1 + b*pow(MY_PI, 4)/5, 2);
+    double V2 = a*a/8;
+    double V13 = b*b*pow(MY_PI, 8)*(1.0/18 - 1.0/50);
+    double V = V1 + V2 + V13;
+
+    ModelInputList inputs;
+    inputs.add("x0").setUniform(-MY_PI, MY_PI);
+    inputs.add("x1").setUniform(-MY_PI, MY_PI);
+    inputs.add("x2").setUniform(-MY_PI, MY_PI);
+
+    PCE sa;
+    sa.setN(200);
+    sa.setDegree(10);
+    sa.setSeed(3);
+    sa.setModelInputList(&inputs);
+    sa.setNumOutputs(1);
+    sa.setEval([](void*) { return std::shared_ptr<ModelEvaluator>(new IshigamiModel()); });
+    sa.analyze();
+
+    const DMatrix* sens = sa.getSens();
+    double tol = 0.01;
+    failures += compare("Ishigami S1", sens->getRow(0)[0], V1/V, tol);
+    failures += compare("Ishigami ST1", sens->getRow(0)[1], (V1+V13)/V, tol);
+    failures += compare("Ishigami S2", sens->getRow(1)[0], V2/V, tol);
+    failures += compare("Ishigami ST2", sens->getRow(1)[1], V2/V, tol);
+    failures += compare("Ishigami S3", sens->getRow(2)[0], 0, tol);
+    failures += compare("Ishigami ST3", sens->getRow(2)[1], V13/V, tol);
+    failures += compare("Ishigami S13", sa.getSens2()->getRow(1)[0], V13/V, tol);
+    failures += compare("Ishigami LOO", sa.getLOOError()[0], 0, tol);
+  }
+
+  /* 2. x0 + 2x1 + x0x2 has the variances 1, 4 and 1, a constant output has
+   * no indices */
+  {
+    ModelInputList inputs;
+    inputs.add("x0").setNormal(0, 1);
+    inputs.add("x1").setNormal(0, 1);
+    inputs.add("x2").setNormal(0, 1);
+
+    PCE sa;
+    sa.setN(100);
+    sa.setDegree(3);
+    sa.setSeed(3);
+    sa.setNumThreads(2);
+    sa.setModelInputList(&inputs);
+    sa.setNumOutputs(2);
+    sa.setEval([](void*) { return std::shared_ptr<ModelEvaluator>(new PolynomialModel()); });
+    sa.analyze();
+
+    const DMatrix* sens = sa.getSens();
+    double tol = 1e-6;
+    failures += compare("polynomial S1", sens->getRow(0)[0], 1.0/6, tol);
+    failures += compare("polynomial ST1", sens->getRow(0)[1], 1.0/3, tol);
+    failures += compare("polynomial S2", sens->getRow(1)[0], 2.0/3, tol);
+    failures += compare("polynomial ST2", sens->getRow(1)[1], 2.0/3, tol);
+    failures += compare("polynomial S3", sens->getRow(2)[0], 0, tol);
+    failures += compare("polynomial ST3", sens->getRow(2)[1], 1.0/6, tol);
+    failures += compare("polynomial S13", sa.getSens2()->getRow(1)[0], 1.0/6, tol);
+
+    for (int iK=0; iK<3; ++iK)
+    {
+      bool nan = std::isnan(sens->getRow(iK)[2]) && std::isnan(sens->getRow(iK)[3]);
+      std::cout << "constant x" << iK << ": " << (nan ? "NaN" : "FAILED") << "\n";
+      failures += !nan;
+    }
+  }
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -50,6 +50,9 @@ int main()
 //  Jansen sa;
 //  EFAST sa;
 //  RBD sa;
+//  RadialOAT sa;
+//  GivenData sa;
+//  PCE sa;
 //    FAST sa;
 //    sa.setUseFFT(true);
 //    sa.setN(2020);
@@ -0,0 +1,167 @@
+/**
+ @file teststream.cpp
+ @brief Checks that streaming the design in blocks of rows leaves the
+ estimates unchanged
+ @author Thai Quang Tung (tungtq), tungtq@gmail.com
+  */
+
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <common/CommonDefs.h>
+#include <sens/SA.h>
+
+using namespace reo;
+
+namespace
+{
+  const double MY_PI = 3.141592653589793238462643383279502884;
+  const char* CHECKPOINT = "teststream.ckpt";
+
+  /* Ishigami function and a second output. Samples with x1 > 3 fail */
+  class TwoOutputModel : public ModelEvaluator
+  {
+    public:
+      TwoOutputModel()
+        : ModelEvaluator(3, 2)
+      {
+      }
+
+      int solve(const double* x, double* y) const
+      {
+        y[0] = sin(x[0]) + 7*pow(sin(x[1]), 2) + 0.1*pow(x[2], 4)*sin(x[0]);
+        y[1] = x[0]*x[2] + x[1];
+        return x[1] > 3 ? 1 : SATOOLS_SUCCESS;
+      }
+  };
+
+  typedef std::function<SALessSimple* ()> Factory_t;
+
+  /* Runs a seeded analysis, streamed in blocks of rows if block>0 */
+  std::unique_ptr<SALessSimple> run(Factory_t create, const ModelInputList& inputs,
+      const SamplingMethod_t sampling, const int block, const int depth,
+      const bool checkpoint)
+  {
+    std::unique_ptr<SALessSimple> sa(create());
+    sa->setModelInputList(&inputs);
+    sa->setNumOutputs(2);
+    sa->setSamplingMethod(sampling);
+    sa->setFailureRate(0.2);
+    sa->setSeed(2024);
+    sa->setNumThreads(3);
+    sa->setChunkSize(4);
+    sa->setBootstrap(20);
+    sa->setPipelineDepth(depth);
+    sa->setStreamBlock(block);
+    if (checkpoint)
+      sa->setCheckpoint(CHECKPOINT);
+    sa->setEval([](void*)
+        {
+          return std::shared_ptr<ModelEvaluator>(new TwoOutputModel());
+        });
+    sa->analyze();
+    if (checkpoint)
+      std::remove(CHECKPOINT);
+    return sa;
+  }
+
+  bool same(const DMatrix* a, const DMatrix* b)
+  {
+    if (a == nullptr || b == nullptr)
+      return a == b;
+    if (a->getNumRows() != b->getNumRows() || a->getNumCols() != b->getNumCols())
+      return false;
+    for (int iRow=0; iRow<a->getNumRows(); ++iRow)
+    {
+      for (int iCol=0; iCol<a->getNumCols(); ++iCol)
+      {
+        double x = a->getRow(iRow)[iCol];
+        double y = b->getRow(iRow)[iCol];
+        if (!(x == y || (std::isnan(x) && std::isnan(y))))
+          return false;
+      }
+    }
+    return true;
+  }
+
+  /* Returns true if the streamed runs give the estimates of the unstreamed
+   * one, bit for bit */
+  bool check(const std::string& name, Factory_t create, const ModelInputList& inputs,
+      const SamplingMethod_t sampling)
+  {
+    bool ok = true;
+    for (int depth : {0, 2})
+    {
+      std::unique_ptr<SALessSimple> ref = run(create, inputs, sampling, 0, depth, false);
+      for (int block : {37, 256})
+      {
+        for (bool checkpoint : {false, true})
+        {
+          std::unique_ptr<SALessSimple> sa = run(create, inputs, sampling, block, depth,
+              checkpoint);
+          bool equal = same(ref->getSens(), sa->getSens())
+            && same(ref->getSensCI(), sa->getSensCI());
+          SobolSaltelli* sobolRef = dynamic_cast<SobolSaltelli*>(ref.get());
+          if (sobolRef != nullptr)
+            equal = equal && same(sobolRef->getSensStdErr(),
+                dynamic_cast<SobolSaltelli*>(sa.get())->getSensStdErr());
+          if (!equal)
+          {
+            std::cout << name << " sampling " << sampling << " depth " << depth
+              << " block " << block << (checkpoint ? " checkpointed" : "")
+              << ": FAILED\n";
+          }
+          ok = ok && equal;
+        }
+      }
+    }
+    if (ok)
+      std::cout << name << " sampling " << sampling << ": ok\n";
+    return ok;
+  }
+}
+
+int main()
+{
+  ModelInputList inputs;
+  inputs.add("x0").setUniform(-MY_PI, MY_PI);
+  inputs.add("x1").setUniform(-MY_PI, MY_PI);
+  inputs.add("x2").setUniform(-MY_PI, MY_PI);
+
+  int failures = 0;
+  for (SamplingMethod_t sampling : {MC_SAMPLING, SOBOL_SAMPLING})
+  {
+    failures += !check("SobolSaltelli", []()
+        {
+          SobolSaltelli* sa = new SobolSaltelli();
+          sa->setN(500);
+          return sa;
+        }, inputs, sampling);
+    failures += !check("DGSM", []()
+        {
+          DGSM* sa = new DGSM();
+          sa->setN(500);
+          return sa;
+        }, inputs, sampling);
+  }
+  failures += !check("SobolSaltelli replicates", []()
+      {
+        SobolSaltelli* sa = new SobolSaltelli();
+        sa->setN(512);
+        sa->setReplicates(4);
+        return sa;
+      }, inputs, SCRAMBLED_SOBOL_SAMPLING);
+  failures += !check("EFAST", []()
+      {
+        EFAST* sa = new EFAST();
+        sa->setN(501);
+        sa->setNr(2);
+        return sa;
+      }, inputs, LHS_SAMPLING);
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}